@@ -0,0 +1,104 @@
+/*
+ * Peter Nguyen
+ * CSCI 411 - Cooperating Processes - Aggregator
+ *
+ * Compile with `-std=c++11 -lrt`
+ */
+
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "messages.h"
+#include "message_queues.h"
+#include "temperature.h"
+
+// An aggregator stands between the server and some of its clients. It
+// connects to its children like the server does, to its parent like a
+// client does, and every round sends the parent one SUBTREE message for
+// all its clients, then passes the central temperature back down. With
+// aggregators of at most FAN_IN children the server only hears from a
+// few, and a round takes a number of hops that grows with log N.
+
+child_queues children;
+parent_queue server;
+
+const long aggregator_id = getpid();
+
+/// Close all queues on quit
+void quit(int signal = 0) {
+  close_children(children);
+  close_parent(server);
+
+  if (signal == SIGINT || signal == 0) {
+    exit(0);
+  } else {
+    exit(1);
+  }
+}
+
+void print_usage() {
+  std::cout << "Usage: aggregator NUM_CHILDREN NAME [PARENT] [FIRST]\n"
+            << "    NUM_CHILDREN - The number of clients, or aggregators, that connect to this one\n"
+            << "    NAME - The queue they connect to, e.g. /temperature-aggregator-1\n"
+            << "    PARENT - The queue of the server or aggregator above (default " << server_queue_name << ")\n"
+            << "    FIRST - The number of the first client, if the children are clients (default 0)\n"
+            << "Children wait up to " << connect_wait.count() << " s for their parent to start; tree.sh starts a whole tree\n";
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 3 || argc > 5) {
+    std::cerr << "Error: Wrong number of arguments!\n\n";
+    print_usage();
+    return 1;
+  }
+
+  size_t num_children;
+  long first_number = 0;
+  std::string name = argv[2], parent_name = argc >= 4 ? argv[3] : server_queue_name;
+
+  // Parse arguments
+  try {
+    long count = std::stol(argv[1]);
+    if (count <= 0 || name.size() < 2 || name[0] != '/') throw std::exception();
+    num_children = static_cast<size_t>(count);
+    if (argc == 5 && (first_number = std::stol(argv[4])) < 0) throw std::exception();
+  } catch (std::exception &e) {
+    std::cerr << "Error: Invalid arguments!\n\n";
+    print_usage();
+    return 1;
+  }
+
+  signal(SIGINT, &quit);
+  raise_queue_limits();
+
+  std::string who = "Aggregator " + name;
+  std::cout << who << ": Started!" << std::endl;
+
+  // Children first, so the parent only hears from whole subtrees
+  if (!open_children(children, who, name, num_children, first_number) || !connect_children(children)) {
+    quit();
+  }
+  if (connect_parent(server, who, parent_name, aggregator_id, 1, first_client(children)) == -1) {
+    quit();
+  }
+
+  std::vector<subtree_temps> subtrees(num_children);
+  message server_message;
+  while (server_message.type != DONE) {
+    if (!receive_subtrees(children, subtrees)
+        || !send_parent(server, message(SUBTREE, combine(subtrees.data(), subtrees.size())))) {
+      quit();
+    }
+
+    // TEMPERATURE or DONE goes down as it came
+    if (!receive_parent(server, server_message) || !send_children(children, server_message)) {
+      quit();
+    }
+  }
+
+  std::cout << who << ": Received DONE" << std::endl;
+
+  quit(0);
+}
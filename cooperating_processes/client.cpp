@@ -8,24 +8,24 @@
 #include <cstdlib>
 #include <csignal>
 #include <iostream>
-#include <fcntl.h>
-#include <sys/stat.h>
-#include <mqueue.h>
 #include <unistd.h>
 #include <sstream>
-#include <functional>
+#include <string>
 #include <iomanip>
 #include "messages.h"
+#include "message_queues.h"
+#include "shared_memory.h"
+#include "temperature.h"
 
-const size_t num_clients = 4;
-mqd_t qd_client_send, qd_client_recv;
+parent_queue server;
+shared_header *shared = nullptr;
 
 const long client_id = getpid();
 
 /// Close all queues on quit
 void quit(int signal = 0) {
-  mq_close(qd_client_send);
-  mq_close(qd_client_recv);
+  close_parent(server);
+  shared_memory_detach(shared);
 
   if (signal == SIGINT || signal == 0) {
     exit(0);
@@ -44,116 +44,197 @@ void print_message(const std::string &message) {
   std::cout << "Client " << client_id << ": " << message << std::endl;
 }
 
-/// Converts a client number to the starting temp
-double client_number_to_temp(long number) {
-  switch (number) {
-    case 0: return 100;
-    case 1: return 22;
-    case 2: return 50;
-    case 3: return 40;
-    default: return 0;
-  }
+/// Moves the client's temperature toward the central temperature
+double next_temperature(double current_temp, double central_temp) {
+  return apply_rule(client_rule, current_temp, central_temp, 1);
 }
 
-int main() {
-  signal(SIGINT, &quit);
-
-  print_message("Started!");
-
-  mq_attr attr = {};
-  attr.mq_flags = 0;
-  attr.mq_maxmsg = max_messages;
-  attr.mq_msgsize = sizeof(message);
-  attr.mq_curmsgs = 0;
-
-  double central_temperature;
-  double current_temperature;
-
-  print_message("Connecting to server");
+/// Logs the temperature the client is sending
+void print_sending(double current_temp) {
+  std::stringstream log_msg;
+  log_msg << "Sending " << std::setprecision(4) << std::fixed << current_temp;
+  print_message(log_msg.str());
+}
 
-  // Create recv message queue
-  std::stringstream client_recv_name_ss;
-  client_recv_name_ss << server_client_queue_name << client_id;
-  std::string client_recv_name = client_recv_name_ss.str();
-  if ((qd_client_recv = mq_open(client_recv_name.c_str(), O_RDONLY | O_CREAT, queue_permissions, &attr)) == -1) {
-    print_error("Could not create receive queue");
-    quit();
+/// Asynchronous mode: moves toward the latest central temperature without
+/// waiting for the server, going quiet once within half the tolerance of
+/// it until the server sends another
+///
+/// \param slot the client's slot
+/// \param current_temp the client's temperature
+void run_async(seqlock_slot &slot, double &current_temp) {
+  size_t updates = 0;
+  while (true) {
+    uint32_t version;
+    double central_temp = shared->read_central(version);
+    if (shared->done.load(std::memory_order_relaxed)) break;
+
+    slot.write(current_temp);
+    ++updates;
+    bool quiet = std::abs(current_temp - central_temp) <= stable_tolerance / 2 && shared->go_quiet(version);
+    shared->changed();
+
+    if (quiet) {
+      shared->round.wait_change(version);
+    } else {
+      current_temp = next_temperature(current_temp, central_temp);
+    }
   }
 
-  // Connect to server
-  mqd_t qd_server;
-  if ((qd_server = mq_open(server_queue_name, O_WRONLY)) == -1) {
+  std::stringstream log_msg;
+  log_msg << "Settled at " << std::setprecision(4) << std::fixed << current_temp << " after " << updates << " updates";
+  print_message(log_msg.str());
+}
+
+/// Exchanges temperatures with the server through shared memory
+/// A client takes the next free slot, and its number is the slot's index.
+void run_shared() {
+  if ((shared = shared_memory_attach()) == nullptr) {
     print_error("Could not connect to server");
     quit();
   }
 
-  // Send SYN
-  message syn_msg(SYN, client_id);
-  if (mq_send(qd_server, (const char *) &syn_msg, sizeof(syn_msg), 0) == -1) {
-    print_error("Could not send SYN to server");
+  uint32_t number = shared->next_client.fetch_add(1);
+  if (number >= shared->num_clients) {
+    print_error("Server already has all of its clients");
     quit();
   }
 
-  // Receive SYN-ACK
-  std::stringstream client_queue_name;
-  message syn_ack_msg;
-  while (syn_ack_msg.type != SYN_ACK) {
-    if (mq_receive(qd_client_recv, (char *) &syn_ack_msg, sizeof(syn_ack_msg), nullptr) == -1) {
-      print_error("Could not receive SYN-ACK");
-      quit();
+  seqlock_slot &slot = shared->slots()[number];
+  double current_temperature = client_number_to_temp(number);
+
+  // The server cannot start a round before every client arrives, so the
+  // round read before arriving is the one to wait out
+  uint32_t round = shared->round.value.load(std::memory_order_acquire);
+  while (true) {
+    print_sending(current_temperature);
+    slot.write(current_temperature);
+    shared->arrive();
+
+    round = shared->round.wait_change(round);
+    if (shared->done.load(std::memory_order_relaxed)) break;
+
+    current_temperature = next_temperature(current_temperature, shared->central.read());
+    if (shared->asynchronous) {
+      run_async(slot, current_temperature);
+      break;
     }
   }
 
+  print_message("Received DONE");
+}
+
+/// Exchanges temperatures with the server, or an aggregator, through
+/// message queues
+///
+/// \param server_name the queue to send SYN to
+void run_message_queues(const std::string &server_name) {
+  print_message("Connecting to server");
+
+  std::stringstream who;
+  who << "Client " << client_id;
+  long number = connect_parent(server, who.str(), server_name, client_id);
+  if (number == -1) quit();
+
   // Get the client's temperature
-  current_temperature = client_number_to_temp(syn_ack_msg.data.long_val);
-
-  // Connect to client send
-  std::stringstream client_send_name_ss;
-  client_send_name_ss << client_server_queue_name << client_id;
-  std::string client_send_name = client_send_name_ss.str();
-  if ((qd_client_send = mq_open(client_send_name.c_str(), O_WRONLY)) == 1) {
-    print_error("Could not connect to client-to-server queue");
-    quit();
+  double current_temperature = client_number_to_temp(number);
+
+  // Send the current temperature, then answer each central temperature
+  message server_message;
+  while (true) {
+    print_sending(current_temperature);
+    if (!send_parent(server, message(TEMPERATURE, current_temperature))) quit();
+
+    if (!receive_parent(server, server_message)) quit();
+    if (server_message.type == DONE) break;
+    current_temperature = next_temperature(current_temperature, server_message.data.double_val);
   }
 
-  // Send ACK
-  message ack_msg(ACK, client_id);
-  if (mq_send(qd_client_send, (const char *) &ack_msg, sizeof(ack_msg), 0) == -1) {
-    print_error("Could not send ACK to server");
-    quit();
+  print_message("Received DONE");
+}
+
+/// Runs many nodes, each a client of its own to the server, sending all
+/// of their temperatures in one batch a round
+///
+/// \param server_name the queue to send SYN to
+/// \param nodes the number of nodes, at most max_batch_entries
+void run_batch(const std::string &server_name, long nodes) {
+  print_message("Connecting to server");
+
+  std::stringstream who;
+  who << "Client " << client_id;
+  long first = connect_parent(server, who.str(), server_name, client_id, nodes);
+  if (first == -1) quit();
+
+  // The batch holds the nodes' temperatures between rounds
+  static batch_message batch;
+  batch.count = static_cast<uint32_t>(nodes);
+  for (uint32_t i = 0; i < batch.count; ++i) {
+    batch_entry entry = {static_cast<uint32_t>(first + i), 0, client_number_to_temp(first + i)};
+    batch.entries[i] = entry;
   }
 
-  std::function<void()> send_current_temp = [&current_temperature]() {
+  message server_message;
+  while (true) {
     std::stringstream log_msg;
-    log_msg << "Sending " << std::setprecision(4) << std::fixed << current_temperature;
+    log_msg << "Sending " << nodes << " temperatures, #" << first << " at "
+            << std::setprecision(4) << std::fixed << batch.entries[0].value;
     print_message(log_msg.str());
+    if (!send_parent_batch(server, batch)) quit();
 
-    message current_temp_msg(TEMPERATURE, current_temperature);
-    if (mq_send(qd_client_send, (const char *) &current_temp_msg, sizeof(current_temp_msg), 0) == -1) {
-      print_error("Could not send temperature to server");
-      quit();
+    if (!receive_parent(server, server_message)) quit();
+    if (server_message.type == DONE) break;
+    for (uint32_t i = 0; i < batch.count; ++i) {
+      batch.entries[i].value = next_temperature(batch.entries[i].value, server_message.data.double_val);
+      ++batch.entries[i].round;
     }
-  };
+  }
 
-  send_current_temp();
+  print_message("Received DONE");
+}
 
-  message server_message;
-  while (server_message.type != DONE) {
-    if (mq_receive(qd_client_recv, (char *) &server_message, sizeof(server_message), nullptr) == -1) {
-      print_error("Could not receive temperature");
-      quit();
-    }
+void print_usage() {
+  std::cout << "Usage: client [TRANSPORT] [SERVER] [NODES]\n"
+            << "    TRANSPORT - mqueue or shm, as given to the server (default mqueue)\n"
+            << "    SERVER - With mqueue, the queue of the server or aggregator to connect to\n"
+            << "             (default " << server_queue_name << ")\n"
+            << "    NODES - With mqueue, the clients to run in this process, sent in batches\n"
+            << "            (default 1, at most " << max_batch_entries << ")\n";
+}
 
-    if (server_message.type == TEMPERATURE) {
-      central_temperature = server_message.data.double_val;
-      current_temperature = (current_temperature * 3 + 2 * central_temperature) / 5;
+int main(int argc, char *argv[]) {
+  Transport transport = MESSAGE_QUEUE;
+  std::string server_name = server_queue_name;
+  long nodes = 1;
 
-      // Send current temperature to server
-      send_current_temp();
+  // Parse arguments
+  try {
+    if (argc > 4 || (argc >= 2 && !parse_transport(argv[1], transport))
+        || (argc >= 3 && transport != MESSAGE_QUEUE)) {
+      throw std::exception();
     }
+    if (argc >= 3) server_name = argv[2];
+    if (argc == 4) {
+      nodes = std::stol(argv[3]);
+      if (nodes <= 0 || nodes > static_cast<long>(max_batch_entries)) throw std::exception();
+    }
+  } catch (std::exception &e) {
+    std::cerr << "Error: Invalid arguments!\n\n";
+    print_usage();
+    return 1;
   }
 
-  print_message("Received DONE");
+  signal(SIGINT, &quit);
+
+  print_message("Started!");
+
+  if (transport == SHARED_MEMORY) {
+    run_shared();
+  } else if (nodes > 1) {
+    run_batch(server_name, nodes);
+  } else {
+    run_message_queues(server_name);
+  }
 
   quit(0);
 }
@@ -0,0 +1,123 @@
+/*
+ * Peter Nguyen
+ * CSCI 411 - Cooperating Processes - Diffusion
+ *
+ * Compile with `-std=c++11 -O3 -ffp-contract=off -pthread`
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "diffusion.h"
+
+/// Reads a graph from a text file: the number of nodes, then one line per
+/// node with its kind (s for server, c for client), its starting
+/// temperature, its number of neighbors and their node numbers
+diffusion_graph read_graph(const std::string &path) {
+  std::ifstream in(path);
+  if (!in) throw std::invalid_argument("Could not open " + path);
+
+  size_t nodes;
+  if (!(in >> nodes)) throw std::invalid_argument("Missing node count in " + path);
+
+  diffusion_graph graph;
+  graph.offsets.push_back(0);
+  for (size_t node = 0; node < nodes; ++node) {
+    char kind;
+    double temp;
+    size_t degree;
+    if (!(in >> kind >> temp >> degree) || (kind != 's' && kind != 'c')) {
+      throw std::invalid_argument("Bad node line in " + path);
+    }
+    for (size_t i = 0; i < degree; ++i) {
+      uint32_t neighbor;
+      if (!(in >> neighbor)) throw std::invalid_argument("Missing neighbor in " + path);
+      graph.neighbors.push_back(neighbor);
+    }
+    graph.offsets.push_back(graph.neighbors.size());
+    graph.is_client.push_back(kind == 'c');
+    graph.temps.push_back(temp);
+  }
+  graph.validate();
+  return graph;
+}
+
+/// Builds a graph from its description: star:CLIENTS, grid:WIDTHxHEIGHT or csr:FILE
+diffusion_graph make_graph(const std::string &spec) {
+  size_t colon = spec.find(':');
+  if (colon == std::string::npos) throw std::invalid_argument("Unknown graph " + spec);
+  std::string kind = spec.substr(0, colon), args = spec.substr(colon + 1);
+
+  if (kind == "star") {
+    return diffusion_graph::star(std::stoul(args));
+  }
+  if (kind == "grid") {
+    size_t x = args.find('x');
+    if (x == std::string::npos) throw std::invalid_argument("A grid is WIDTHxHEIGHT");
+    return diffusion_graph::grid(std::stoul(args.substr(0, x)), std::stoul(args.substr(x + 1)));
+  }
+  if (kind == "csr") {
+    return read_graph(args);
+  }
+  throw std::invalid_argument("Unknown graph " + spec);
+}
+
+void print_usage() {
+  std::cout << "Usage: diffusion GRAPH [THREADS] [MAX_ROUNDS]\n"
+            << "    GRAPH - star:CLIENTS, grid:WIDTHxHEIGHT or csr:FILE\n"
+            << "    THREADS - The number of threads (default one per CPU)\n"
+            << "    MAX_ROUNDS - Stop after this many rounds if not stable (default 100000)\n"
+            << "A csr FILE holds the number of nodes, then per node: s or c, the starting\n"
+            << "temperature, the number of neighbors and their node numbers\n";
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2 || argc > 4) {
+    std::cerr << "Error: Wrong number of arguments!\n\n";
+    print_usage();
+    return 1;
+  }
+
+  long threads = std::max(1u, std::thread::hardware_concurrency());
+  long max_rounds = 100000;
+  diffusion_graph graph;
+
+  // Parse arguments
+  try {
+    graph = make_graph(argv[1]);
+    if (argc >= 3) threads = std::stol(argv[2]);
+    if (argc == 4) max_rounds = std::stol(argv[3]);
+    if (threads <= 0 || max_rounds <= 0) throw std::invalid_argument("Invalid arguments!");
+  } catch (std::exception &e) {
+    std::cerr << "Error: " << e.what() << "\n\n";
+    print_usage();
+    return 1;
+  }
+
+  diffusion_engine engine(graph, static_cast<size_t>(threads));
+  std::cout << "Diffusion: " << engine.size() << " nodes, " << engine.edges() << " edges, "
+            << threads << " threads" << std::endl;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  bool stable = engine.run(static_cast<size_t>(max_rounds));
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::vector<double> temps = engine.temperatures();
+  double low = *std::min_element(temps.begin(), temps.end());
+  double high = *std::max_element(temps.begin(), temps.end());
+
+  std::cout << "Diffusion: " << (stable ? "Stable" : "Not stable") << " after " << engine.rounds() << " rounds in "
+            << std::setprecision(3) << std::fixed << elapsed << " s ("
+            << std::setprecision(1) << engine.rounds() * engine.edges() / elapsed / 1e6 << "M edges/s)\n"
+            << "Diffusion: Node 0 at " << std::setprecision(4) << temps[0]
+            << ", all nodes between " << low << " and " << high << std::endl;
+
+  // Every digit, to compare against the server
+  std::cout << "Diffusion: Node 0 exactly " << std::defaultfloat << std::setprecision(17) << temps[0] << std::endl;
+  return 0;
+}
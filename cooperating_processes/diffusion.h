@@ -0,0 +1,411 @@
+//
+// Created by Peter on 10/17/2026.
+//
+
+#ifndef CSCI411_DIFFUSION_H
+#define CSCI411_DIFFUSION_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "temperature.h"
+
+// In-process diffusion engine
+// Applies the server and client rules to every node of a graph at once,
+// instead of one process per node. Each round the server nodes update
+// from their neighbors' temperatures, then the client nodes update from
+// the servers' new ones, exactly as the clients answer the server's
+// central temperature. Sums are added in neighbor order, so a star of
+// four clients gives the same numbers, bit for bit, as the server does.
+
+/// A graph in compressed sparse row form
+/// Node i's neighbors are neighbors[offsets[i]] to neighbors[offsets[i + 1] - 1].
+struct diffusion_graph {
+  std::vector<size_t> offsets;
+  std::vector<uint32_t> neighbors;
+  std::vector<uint8_t> is_client;  // 1 for client nodes, 0 for server nodes
+  std::vector<double> temps;       // Starting temperatures
+
+  size_t size() const {
+    return temps.size();
+  }
+
+  size_t degree(size_t node) const {
+    return offsets[node + 1] - offsets[node];
+  }
+
+  /// Checks the arrays agree with each other
+  void validate() const {
+    size_t nodes = temps.size();
+    if (nodes == 0) throw std::invalid_argument("A graph needs at least one node");
+    if (nodes > std::numeric_limits<uint32_t>::max()) throw std::invalid_argument("A graph has at most 2^32 - 1 nodes");
+    if (is_client.size() != nodes || offsets.size() != nodes + 1 || offsets[0] != 0
+        || offsets[nodes] != neighbors.size()) {
+      throw std::invalid_argument("Graph arrays do not match in size");
+    }
+    for (size_t i = 0; i < nodes; ++i) {
+      if (offsets[i] > offsets[i + 1]) throw std::invalid_argument("Graph offsets must not decrease");
+    }
+    for (uint32_t neighbor : neighbors) {
+      if (neighbor >= nodes) throw std::invalid_argument("Graph neighbor out of range");
+    }
+  }
+
+  /// The server's graph: node 0 is the server, at temperature 0, and nodes
+  /// 1 to num_clients are clients starting as client.cpp does
+  static diffusion_graph star(size_t num_clients) {
+    diffusion_graph graph;
+    graph.offsets.push_back(0);
+    graph.offsets.push_back(num_clients);
+    graph.is_client.push_back(0);
+    graph.temps.push_back(0.0);
+    for (size_t i = 0; i < num_clients; ++i) {
+      graph.neighbors.push_back(static_cast<uint32_t>(i + 1));
+    }
+    for (size_t i = 0; i < num_clients; ++i) {
+      graph.neighbors.push_back(0);
+      graph.offsets.push_back(graph.neighbors.size());
+      graph.is_client.push_back(1);
+      graph.temps.push_back(client_number_to_temp(static_cast<long>(i)));
+    }
+    graph.validate();
+    return graph;
+  }
+
+  /// A width by height plate. Cells are colored like a checkerboard, so
+  /// each server cell only touches client cells and the other way round.
+  /// Starting temperatures repeat as for clients.
+  static diffusion_graph grid(size_t width, size_t height) {
+    diffusion_graph graph;
+    graph.offsets.push_back(0);
+    for (size_t row = 0; row < height; ++row) {
+      for (size_t col = 0; col < width; ++col) {
+        size_t cell = row * width + col;
+        if (row > 0) graph.neighbors.push_back(static_cast<uint32_t>(cell - width));
+        if (col > 0) graph.neighbors.push_back(static_cast<uint32_t>(cell - 1));
+        if (col + 1 < width) graph.neighbors.push_back(static_cast<uint32_t>(cell + 1));
+        if (row + 1 < height) graph.neighbors.push_back(static_cast<uint32_t>(cell + width));
+        graph.offsets.push_back(graph.neighbors.size());
+        graph.is_client.push_back(static_cast<uint8_t>((row + col) % 2));
+        graph.temps.push_back(client_number_to_temp(static_cast<long>(cell)));
+      }
+    }
+    graph.validate();
+    return graph;
+  }
+};
+
+/// Runs the diffusion rounds over a graph on a few threads
+///
+/// Nodes are renumbered so the servers come first, then the clients, each
+/// in their original order, and temperatures, sums and divisors are kept
+/// in separate arrays. Each phase first adds up neighbor sums, in tasks of
+/// about task_edges edges handed out to threads, then applies the rule
+/// over contiguous ranges, a loop the compiler turns into SIMD
+/// instructions. A node with more than task_edges neighbors is split over
+/// several tasks whose sums are added in order, so results never depend
+/// on the number of threads.
+class diffusion_engine {
+ public:
+  static const size_t task_edges = 4096;
+
+ private:
+  /// Neighbor sums for a run of nodes, or part of one node's sum
+  struct sum_task {
+    size_t first, last;    // Nodes
+    size_t edge_first, edge_last;
+    size_t partial;        // Where a split node's part goes, or no_partial
+  };
+
+  /// A node whose sum is split over several tasks
+  struct split_node {
+    size_t node;
+    size_t first_partial, count;
+  };
+
+  /// One of the two halves of a round
+  struct phase {
+    size_t first, last;  // Nodes
+    update_rule rule;
+    std::vector<sum_task> tasks;
+    std::vector<split_node> splits;
+  };
+
+  static const size_t no_partial = static_cast<size_t>(-1);
+
+  /// Stops every thread until all of them reach it
+  class barrier {
+   private:
+    std::mutex mutex;
+    std::condition_variable released;
+    size_t count, waiting = 0, generation = 0;
+
+   public:
+    explicit barrier(size_t count) : count(count) {}
+
+    void arrive_and_wait() {
+      std::unique_lock<std::mutex> lock(mutex);
+      size_t arrived_in = generation;
+      if (++waiting == count) {
+        waiting = 0;
+        ++generation;
+        released.notify_all();
+      } else {
+        released.wait(lock, [&]() { return generation != arrived_in; });
+      }
+    }
+  };
+
+  size_t num_nodes;
+  std::vector<size_t> offsets;
+  std::vector<uint32_t> neighbors;
+  std::vector<uint32_t> position;  // Original node to renumbered node
+
+  std::vector<double> temp, sum, scale, partials;
+  phase phases[2];
+
+  size_t num_threads;
+  std::vector<std::thread> workers;
+  barrier sync;
+  bool stopping = false;
+  std::vector<uint8_t> unstable;  // One flag per thread, set in the client phase
+  size_t rounds_run = 0;
+
+  /// Splits [first, last) into num_threads ranges, on cache line boundaries
+  void chunk(size_t first, size_t last, size_t thread, size_t &from, size_t &to) const {
+    const size_t align = 8;
+    size_t per = ((last - first + num_threads - 1) / num_threads + align - 1) / align * align;
+    from = std::min(last, first + thread * per);
+    to = std::min(last, from + per);
+  }
+
+  /// Builds the sum tasks of a phase
+  void plan(phase &each) {
+    sum_task task = {each.first, each.first, offsets[each.first], offsets[each.first], no_partial};
+    for (size_t node = each.first; node < each.last; ++node) {
+      size_t degree = offsets[node + 1] - offsets[node];
+      if (degree <= task_edges) {
+        // Zero-degree nodes still cost something
+        if (task.edge_last - task.edge_first + (node - task.first) + degree + 1 > task_edges && task.last > task.first) {
+          each.tasks.push_back(task);
+          task = {node, node, offsets[node], offsets[node], no_partial};
+        }
+        task.last = node + 1;
+        task.edge_last = offsets[node + 1];
+        continue;
+      }
+
+      if (task.last > task.first) each.tasks.push_back(task);
+      split_node split = {node, partials.size(), 0};
+      for (size_t edge = offsets[node]; edge < offsets[node + 1]; edge += task_edges) {
+        size_t end = std::min(offsets[node + 1], edge + task_edges);
+        each.tasks.push_back({node, node + 1, edge, end, partials.size()});
+        partials.push_back(0.0);
+        split.count++;
+      }
+      each.splits.push_back(split);
+      task = {node + 1, node + 1, offsets[node + 1], offsets[node + 1], no_partial};
+    }
+    if (task.last > task.first) each.tasks.push_back(task);
+  }
+
+  /// Adds up neighbor temperatures for this thread's tasks of a phase
+  void add_sums(const phase &each, size_t thread) {
+    const double *temps = temp.data();
+    const uint32_t *adjacent = neighbors.data();
+    for (size_t t = thread; t < each.tasks.size(); t += num_threads) {
+      const sum_task &task = each.tasks[t];
+      if (task.partial != no_partial) {
+        double total = 0.0;
+        for (size_t edge = task.edge_first; edge < task.edge_last; ++edge) total += temps[adjacent[edge]];
+        partials[task.partial] = total;
+        continue;
+      }
+      for (size_t node = task.first; node < task.last; ++node) {
+        double total = 0.0;
+        for (size_t edge = offsets[node]; edge < offsets[node + 1]; ++edge) total += temps[adjacent[edge]];
+        sum[node] = total;
+      }
+    }
+  }
+
+  /// Applies the phase's rule to this thread's range of nodes
+  void apply(const phase &each, size_t thread) {
+    size_t from, to;
+    chunk(each.first, each.last, thread, from, to);
+
+    for (const split_node &split : each.splits) {
+      if (split.node < from || split.node >= to) continue;
+      double total = 0.0;
+      for (size_t i = 0; i < split.count; ++i) total += partials[split.first_partial + i];
+      sum[split.node] = total;
+    }
+
+    // Same arithmetic as apply_rule, with the divisor worked out ahead
+    double *__restrict temps = temp.data();
+    const double *__restrict sums = sum.data();
+    const double *__restrict scales = scale.data();
+    const double self = each.rule.self, neighbor = each.rule.neighbor;
+    for (size_t node = from; node < to; ++node) {
+      temps[node] = (self * temps[node] + neighbor * sums[node]) / scales[node];
+    }
+  }
+
+  /// Checks this thread's range of clients against their left neighbors,
+  /// as the server does before the clients move
+  void check_stable(size_t thread) {
+    size_t from, to;
+    chunk(phases[1].first, phases[1].last, thread, from, to);
+    from = std::max(from, phases[1].first + 1);
+
+    const double *temps = temp.data();
+    bool moved = false;
+    for (size_t node = from; node < to; ++node) {
+      moved |= std::abs(temps[node] - temps[node - 1]) > stable_tolerance;
+    }
+    unstable[thread] = moved;
+  }
+
+  /// One thread's share of a round
+  void round(size_t thread) {
+    add_sums(phases[0], thread);
+    wait();
+    apply(phases[0], thread);
+    wait();
+    add_sums(phases[1], thread);
+    check_stable(thread);
+    wait();
+    apply(phases[1], thread);
+    wait();
+  }
+
+  void wait() {
+    if (num_threads > 1) sync.arrive_and_wait();
+  }
+
+  void work(size_t thread) {
+    while (true) {
+      sync.arrive_and_wait();
+      if (stopping) return;
+      round(thread);
+    }
+  }
+
+ public:
+  /// Copies a graph into the engine and starts its threads
+  ///
+  /// \param graph the graph and starting temperatures
+  /// \param threads the number of threads, at least one
+  diffusion_engine(const diffusion_graph &graph, size_t threads)
+      : num_nodes(graph.size()), num_threads(std::max<size_t>(threads, 1)), sync(num_threads),
+        unstable(num_threads, 0) {
+    graph.validate();
+
+    // Servers first, then clients, each kept in order
+    std::vector<uint32_t> original;
+    for (uint8_t client = 0; client < 2; ++client) {
+      for (size_t node = 0; node < num_nodes; ++node) {
+        if ((graph.is_client[node] != 0) == (client != 0)) original.push_back(static_cast<uint32_t>(node));
+      }
+    }
+    position.resize(num_nodes);
+    for (size_t i = 0; i < num_nodes; ++i) position[original[i]] = static_cast<uint32_t>(i);
+
+    offsets.reserve(num_nodes + 1);
+    offsets.push_back(0);
+    neighbors.reserve(graph.neighbors.size());
+    temp.resize(num_nodes);
+    sum.resize(num_nodes);
+    scale.resize(num_nodes);
+    size_t num_servers = 0;
+    for (size_t i = 0; i < num_nodes; ++i) {
+      uint32_t node = original[i];
+      for (size_t edge = graph.offsets[node]; edge < graph.offsets[node + 1]; ++edge) {
+        neighbors.push_back(position[graph.neighbors[edge]]);
+      }
+      offsets.push_back(neighbors.size());
+      temp[i] = graph.temps[node];
+
+      const update_rule &rule = graph.is_client[node] ? client_rule : server_rule;
+      scale[i] = rule.self + rule.neighbor * static_cast<double>(graph.degree(node));
+      if (!graph.is_client[node]) num_servers++;
+    }
+
+    phases[0].first = 0;
+    phases[0].last = num_servers;
+    phases[0].rule = server_rule;
+    phases[1].first = num_servers;
+    phases[1].last = num_nodes;
+    phases[1].rule = client_rule;
+    plan(phases[0]);
+    plan(phases[1]);
+
+    for (size_t thread = 1; thread < num_threads; ++thread) {
+      workers.emplace_back(&diffusion_engine::work, this, thread);
+    }
+  }
+
+  diffusion_engine(const diffusion_engine &) = delete;
+  diffusion_engine &operator=(const diffusion_engine &) = delete;
+
+  ~diffusion_engine() {
+    stopping = true;
+    if (num_threads > 1) sync.arrive_and_wait();
+    for (std::thread &worker : workers) worker.join();
+  }
+
+  /// Runs one round
+  ///
+  /// \return if the clients were stable going into the round, which is
+  ///         when the server would send DONE after it
+  bool step() {
+    if (num_threads > 1) sync.arrive_and_wait();
+    round(0);
+    rounds_run++;
+    return std::find(unstable.begin(), unstable.end(), 1) == unstable.end();
+  }
+
+  /// Runs rounds until the clients are stable
+  ///
+  /// \param max_rounds the most rounds to run
+  /// \return if the clients became stable
+  bool run(size_t max_rounds) {
+    for (size_t i = 0; i < max_rounds; ++i) {
+      if (step()) return true;
+    }
+    return false;
+  }
+
+  /// Returns the number of rounds run
+  size_t rounds() const {
+    return rounds_run;
+  }
+
+  size_t size() const {
+    return num_nodes;
+  }
+
+  size_t edges() const {
+    return neighbors.size();
+  }
+
+  /// Returns a node's temperature, by its number in the graph
+  double temperature(size_t node) const {
+    return temp[position.at(node)];
+  }
+
+  /// Returns every temperature, in the graph's numbering
+  std::vector<double> temperatures() const {
+    std::vector<double> result(num_nodes);
+    for (size_t node = 0; node < num_nodes; ++node) result[node] = temp[position[node]];
+    return result;
+  }
+};
+
+#endif //CSCI411_DIFFUSION_H
@@ -0,0 +1,528 @@
+//
+// Created by Peter on 10/17/2026.
+//
+
+#ifndef CSCI411_MESSAGE_QUEUES_H
+#define CSCI411_MESSAGE_QUEUES_H
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <mqueue.h>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "messages.h"
+
+// Message queue transport
+// A process with children (the server, or an aggregator) listens on a
+// named queue for SYNs and keeps a pair of queues per child, all watched
+// by one epoll set. A process with a parent (a client, or an aggregator)
+// sends SYN to the parent's queue and then talks over its own pair.
+// Functions log what went wrong and return false; the caller quits.
+//
+// A client can also speak for many nodes. It asks for them in its SYN,
+// gets consecutive client numbers, and each round sends all of their
+// temperatures in one BATCH message, so a round costs it one send and one
+// receive however many nodes it runs.
+
+/// Tags the listening queue in epoll events; children are tagged with their number
+const uint64_t listen_tag = UINT64_MAX;
+
+/// Most ready queues taken from epoll at once
+const int max_events = 256;
+
+/// How long a child waits for its parent's queue to appear, so a tree can
+/// start in any order
+const std::chrono::seconds connect_wait(10);
+
+/// Returns the attributes every queue is created with
+inline mq_attr queue_attributes() {
+  mq_attr attr = {};
+  attr.mq_flags = 0;
+  attr.mq_maxmsg = max_messages;
+  attr.mq_msgsize = sizeof(message);
+  attr.mq_curmsgs = 0;
+  return attr;
+}
+
+/// Most messages waiting in a batching child's queue; in lockstep it only
+/// ever sends one round ahead
+const long max_batch_messages = 2;
+
+/// Returns the attributes of the queue a child with nodes sends on, just
+/// big enough for its batches, since queue bytes count against ulimit -q
+inline mq_attr batch_queue_attributes(long nodes) {
+  mq_attr attr = queue_attributes();
+  attr.mq_maxmsg = max_batch_messages;
+  attr.mq_msgsize = static_cast<long>(std::max(sizeof(message), batch_message::size(static_cast<size_t>(nodes))));
+  return attr;
+}
+
+/// Raises the open file and queue size limits as far as allowed, since
+/// every child takes two queue descriptors and two queues' worth of bytes
+inline void raise_queue_limits() {
+  for (int resource : {RLIMIT_NOFILE, RLIMIT_MSGQUEUE}) {
+    rlimit limit = {};
+    if (getrlimit(resource, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+      limit.rlim_cur = limit.rlim_max;
+      setrlimit(resource, &limit);
+    }
+  }
+}
+
+/// The queues to a process's children
+struct child_queues {
+  std::string who;          // Logged before every message
+  std::string listen_name;
+  size_t num_children = 0;
+  long next_number = 0;     // Given to the next child in SYN-ACK; a child with nodes takes that many
+  uint32_t round = 0;       // Rounds received from every child
+  mqd_t listen = -1;
+  std::vector<mqd_t> send, recv;
+  std::vector<std::string> recv_names;
+  std::vector<long> nodes;  // Nodes of each child, more than one if it sends BATCH
+  std::vector<long> firsts; // Number of each child's first client
+  std::vector<size_t> place; // Where each child's run goes, in client order
+  int epoll_fd = -1;
+  batch_message received;   // The last message receive_ready took, of any type
+};
+
+/// Closes the queues to the children
+/// The queues this process created are removed, so runs do not use up
+/// the system's queue limit
+inline void close_children(child_queues &children) {
+  if (children.listen != -1) {
+    mq_close(children.listen);
+    mq_unlink(children.listen_name.c_str());
+    children.listen = -1;
+  }
+  for (mqd_t send_mq : children.send) {
+    mq_close(send_mq);
+  }
+  for (mqd_t recv_mq : children.recv) {
+    mq_close(recv_mq);
+  }
+  for (const std::string &name : children.recv_names) {
+    mq_unlink(name.c_str());
+  }
+  children.send.clear();
+  children.recv.clear();
+  children.recv_names.clear();
+  children.nodes.clear();
+  if (children.epoll_fd != -1) close(children.epoll_fd);
+  children.epoll_fd = -1;
+}
+
+/// Adds a queue to the epoll set. On Linux a message queue descriptor is a
+/// file descriptor, readable while the queue holds a message.
+inline bool watch(child_queues &children, mqd_t queue, uint64_t tag) {
+  epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.u64 = tag;
+  if (epoll_ctl(children.epoll_fd, EPOLL_CTL_ADD, queue, &event) == -1) {
+    std::cerr << children.who << ": Could not watch queue" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+/// Creates the listening queue and the epoll set
+///
+/// \param children set up for num_children children
+/// \param who the name to log with
+/// \param listen_name the queue children send SYN to
+/// \param num_children the number of children to wait for
+/// \param first_number the number of the first child
+inline bool open_children(child_queues &children, const std::string &who, const std::string &listen_name,
+                          size_t num_children, long first_number = 0) {
+  children.who = who;
+  children.listen_name = listen_name;
+  children.num_children = num_children;
+  children.next_number = first_number;
+
+  // Drop SYNs left over from an earlier run
+  mq_attr attr = queue_attributes();
+  mq_unlink(listen_name.c_str());
+  if ((children.listen = mq_open(listen_name.c_str(), O_RDONLY | O_CREAT | O_NONBLOCK, queue_permissions, &attr))
+      == -1) {
+    std::cerr << who << ": Could not create main message queue " << listen_name << std::endl;
+    return false;
+  }
+
+  if ((children.epoll_fd = epoll_create1(0)) == -1) {
+    std::cerr << who << ": Could not create epoll instance" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+/// Waits until at least one watched queue has a message, then receives one
+/// message from every queue that has one, in the order epoll reports them
+///
+/// \param handle called with the tag of the queue, the message, and the
+/// whole of it as a batch when the type is BATCH
+template<typename Handler>
+bool receive_ready(child_queues &children, Handler handle) {
+  epoll_event events[max_events];
+  batch_message &received = children.received;
+  int ready;
+  while ((ready = epoll_wait(children.epoll_fd, events, max_events, -1)) == -1 && errno == EINTR) {}
+  if (ready == -1) {
+    std::cerr << children.who << ": Could not wait for messages" << std::endl;
+    return false;
+  }
+
+  for (int i = 0; i < ready; ++i) {
+    uint64_t tag = events[i].data.u64;
+    mqd_t queue = tag == listen_tag ? children.listen : children.recv[tag];
+
+    // Queues are non-blocking, so a message another wakeup took is just skipped
+    ssize_t length = mq_receive(queue, (char *) &received, sizeof(received), nullptr);
+    if (length == -1) {
+      if (errno == EAGAIN) continue;
+      std::cerr << children.who << ": Could not receive message" << std::endl;
+      return false;
+    }
+    message msg;
+    std::memcpy(static_cast<void *>(&msg), &received, std::min(static_cast<size_t>(length), sizeof(msg)));
+    handle(tag, msg, received);
+  }
+  return true;
+}
+
+/// Replies to a child's SYN with a SYN-ACK of -1, so connect_parent
+/// returns -1 instead of waiting for an answer forever
+///
+/// \param child_id the id the child sent, which names its queues
+inline void refuse_child(const child_queues &children, long child_id) {
+  std::stringstream child_send_queue_name;
+  child_send_queue_name << server_client_queue_name << child_id;
+  mqd_t send_mq = mq_open(child_send_queue_name.str().c_str(), O_WRONLY | O_NONBLOCK);
+  if (send_mq == -1) {
+    std::cerr << children.who << ": Not able to open client queue: " << child_send_queue_name.str() << std::endl;
+    return;
+  }
+  message refusal(SYN_ACK, -1L);
+  mq_send(send_mq, (const char *) &refusal, sizeof(refusal), 0);
+  mq_close(send_mq);
+}
+
+/// Opens the queues of a child that sent SYN and replies with SYN-ACK,
+/// or with a SYN-ACK of -1 if it asked for a number of nodes it cannot have
+///
+/// \param request the id the child sent, which names its queues, and its nodes
+/// \param reachable set to false if the child could not be reached
+/// \return false if the child's queue could not be created
+inline bool accept_child(child_queues &children, const connect_request &request, bool &reachable) {
+  size_t child_number = children.recv.size();
+  long child_id = request.id;
+  std::cout << children.who << ": Client #" << child_number << " connecting with id " << child_id;
+  if (request.nodes > 1) std::cout << " for " << request.nodes << " nodes";
+  std::cout << std::endl;
+  reachable = false;
+
+  if (request.nodes < 1 || request.nodes > static_cast<long>(max_batch_entries)) {
+    std::cerr << children.who << ": Client " << child_id << " asked for " << request.nodes << " nodes" << std::endl;
+    refuse_child(children, child_id);
+    return true;
+  }
+
+  // Connect to client
+  std::stringstream child_send_queue_name;
+  child_send_queue_name << server_client_queue_name << child_id;
+  mqd_t send_mq = mq_open(child_send_queue_name.str().c_str(), O_WRONLY);
+  if (send_mq == -1) {
+    std::cerr << children.who << ": Not able to open client queue: " << child_send_queue_name.str() << std::endl;
+    return true;
+  }
+
+  // Create a client recv queue
+  mq_attr attr = request.nodes > 1 ? batch_queue_attributes(request.nodes) : queue_attributes();
+  std::stringstream child_recv_queue_name;
+  child_recv_queue_name << client_server_queue_name << child_id;
+  mqd_t recv_mq = mq_open(child_recv_queue_name.str().c_str(), O_RDONLY | O_CREAT | O_NONBLOCK,
+                          queue_permissions, &attr);
+  if (recv_mq == -1) {
+    std::cerr << children.who << ": Could not create client to server queue: " << child_recv_queue_name.str()
+              << " (see /proc/sys/fs/mqueue/queues_max and ulimit -q)" << std::endl;
+    mq_close(send_mq);
+    return false;
+  }
+
+  // Send client SYN-ACK
+  message syn_ack_msg(SYN_ACK, children.next_number);
+  if (mq_send(send_mq, (const char *) &syn_ack_msg, sizeof(syn_ack_msg), 0) == -1) {
+    std::cerr << children.who << ": Not able to send SYN-ACK to client: " << child_send_queue_name.str() << std::endl;
+    mq_close(send_mq);
+    mq_close(recv_mq);
+    mq_unlink(child_recv_queue_name.str().c_str());
+    return true;
+  }
+
+  children.send.push_back(send_mq);
+  children.recv.push_back(recv_mq);
+  children.recv_names.push_back(child_recv_queue_name.str());
+  children.nodes.push_back(request.nodes);
+  children.firsts.push_back(request.first >= 0 ? request.first : children.next_number);
+  children.next_number += request.nodes;
+  reachable = true;
+  return watch(children, recv_mq, child_number);
+}
+
+/// Accepts children until all of them have sent ACK. SYNs and ACKs are
+/// handled as they arrive, so a slow child does not hold up the others,
+/// and then places each child by its first client, not by when it connected.
+inline bool connect_children(child_queues &children) {
+  if (!watch(children, children.listen, listen_tag)) return false;
+
+  bool ok = true;
+  size_t acked = 0;
+  std::vector<bool> connected;
+  while (ok && acked < children.num_children) {
+    ok = receive_ready(children, [&](uint64_t tag, const message &msg, const batch_message &) {
+      if (!ok) return;
+      if (tag == listen_tag) {
+        bool reachable;
+        if (msg.type == SYN && children.recv.size() < children.num_children) {
+          ok = accept_child(children, msg.data.request_val, reachable);
+          if (reachable) connected.push_back(false);
+        } else if (msg.type == SYN) {
+          std::cerr << children.who << ": Refusing client " << msg.data.request_val.id << ", all connected" << std::endl;
+          refuse_child(children, msg.data.request_val.id);
+        }
+      } else if (msg.type == ACK && !connected[tag]) {
+        // The child sends its first temperature right after ACK, so stop
+        // reading its queue until the first round starts
+        epoll_ctl(children.epoll_fd, EPOLL_CTL_DEL, children.recv[tag], nullptr);
+        connected[tag] = true;
+        ++acked;
+      }
+    }) && ok;
+  }
+  if (!ok) return false;
+
+  // Refuse SYNs already waiting too; ones sent from now on are never read
+  epoll_ctl(children.epoll_fd, EPOLL_CTL_DEL, children.listen, nullptr);
+  message extra;
+  while (mq_receive(children.listen, (char *) &extra, sizeof(extra), nullptr) != -1) {
+    if (extra.type != SYN) continue;
+    std::cerr << children.who << ": Refusing client " << extra.data.request_val.id << ", all connected" << std::endl;
+    refuse_child(children, extra.data.request_val.id);
+  }
+
+  std::vector<size_t> by_first(children.num_children);
+  std::iota(by_first.begin(), by_first.end(), 0);
+  std::stable_sort(by_first.begin(), by_first.end(),
+                   [&](size_t a, size_t b) { return children.firsts[a] < children.firsts[b]; });
+  children.place.resize(children.num_children);
+  for (size_t i = 0; i < children.num_children; ++i) children.place[by_first[i]] = i;
+  for (size_t i = 0; i < children.num_children; ++i) {
+    if (!watch(children, children.recv[i], i)) return false;
+  }
+  return true;
+}
+
+/// Returns the number of the first client under any of the children
+inline long first_client(const child_queues &children) {
+  return *std::min_element(children.firsts.begin(), children.firsts.end());
+}
+
+/// Joins a child's batch into one run of its nodes, as if each node had
+/// been a client of its own
+///
+/// \param batch the batch
+/// \param nodes the nodes the child connected with
+/// \param round the round being received
+/// \param subtree set to the run
+/// \return false if the batch is not a whole, current round of those nodes
+inline bool batch_subtree(const batch_message &batch, long nodes, uint32_t round, subtree_temps &subtree) {
+  if (batch.version != batch_version || batch.count != static_cast<uint32_t>(nodes)) return false;
+  for (uint32_t i = 0; i < batch.count; ++i) {
+    if (batch.entries[i].round != round) return false;
+    subtree_temps parts[2] = {subtree, single_client(batch.entries[i].value)};
+    subtree = i == 0 ? parts[1] : combine(parts, 2);
+  }
+  return batch.count > 0;
+}
+
+/// Receives a temperature from each child: TEMPERATURE from a client,
+/// BATCH from a client with many nodes, or SUBTREE from an aggregator
+///
+/// Temperatures are taken in whatever order they arrive, so the round
+/// lasts as long as the slowest child
+///
+/// \param subtrees set to what each child reported, in client order
+inline bool receive_subtrees(child_queues &children, std::vector<subtree_temps> &subtrees) {
+  std::vector<bool> received(children.num_children, false);
+  size_t count = 0;
+  bool ok = true;
+  while (ok && count < children.num_children) {
+    ok = receive_ready(children, [&](uint64_t tag, const message &msg, const batch_message &batch) {
+      if (!ok || tag == listen_tag || received[tag]) return;
+      subtree_temps &subtree = subtrees[children.place[tag]];
+      if (msg.type == TEMPERATURE) {
+        subtree = single_client(msg.data.double_val);
+      } else if (msg.type == SUBTREE) {
+        subtree = msg.data.subtree_val;
+      } else if (msg.type == BATCH) {
+        if (!batch_subtree(batch, children.nodes[tag], children.round, subtree)) {
+          std::cerr << children.who << ": Bad batch from client #" << tag << std::endl;
+          ok = false;
+          return;
+        }
+      } else {
+        return;
+      }
+      received[tag] = true;
+      ++count;
+    }) && ok;
+  }
+  ++children.round;
+  return ok;
+}
+
+/// Sends a message to each child
+inline bool send_children(child_queues &children, const message &msg) {
+  for (mqd_t &send_mq : children.send) {
+    if (mq_send(send_mq, (const char *) &msg, sizeof(msg), 0) == -1) {
+      std::cerr << children.who << ": Could not send " << msg << " to client" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+/// The queues to a process's parent
+struct parent_queue {
+  std::string who;  // Logged before every message
+  mqd_t send = -1, recv = -1;
+  std::string recv_name;
+};
+
+/// Closes the queues to the parent and removes the one this process created
+inline void close_parent(parent_queue &parent) {
+  if (parent.send != -1) mq_close(parent.send);
+  if (parent.recv != -1) mq_close(parent.recv);
+  if (!parent.recv_name.empty()) mq_unlink(parent.recv_name.c_str());
+  parent.send = parent.recv = -1;
+  parent.recv_name.clear();
+}
+
+/// Connects to a parent with the SYN, SYN-ACK, ACK handshake
+///
+/// \param parent set up on success
+/// \param who the name to log with
+/// \param parent_name the parent's listening queue
+/// \param id this process's id, which names its queues
+/// \param nodes the clients this process speaks for; more than one means it sends BATCH
+/// \param first the number of its first client, if it is an aggregator, or -1
+/// \return the number the parent gave this process, or its first node, or -1,
+/// also if the parent refused the connection
+inline long connect_parent(parent_queue &parent, const std::string &who, const std::string &parent_name, long id,
+                           long nodes = 1, long first = -1) {
+  parent.who = who;
+
+  // Create recv message queue
+  mq_attr attr = queue_attributes();
+  std::stringstream recv_name_ss;
+  recv_name_ss << server_client_queue_name << id;
+  parent.recv_name = recv_name_ss.str();
+  if ((parent.recv = mq_open(parent.recv_name.c_str(), O_RDONLY | O_CREAT, queue_permissions, &attr)) == -1) {
+    std::cerr << who << ": Could not create receive queue" << std::endl;
+    parent.recv_name.clear();
+    return -1;
+  }
+
+  // Connect to server, which may still be starting
+  mqd_t qd_server;
+  std::chrono::steady_clock::time_point give_up = std::chrono::steady_clock::now() + connect_wait;
+  while ((qd_server = mq_open(parent_name.c_str(), O_WRONLY)) == -1 && errno == ENOENT
+      && std::chrono::steady_clock::now() < give_up) {
+    usleep(10000);
+  }
+  if (qd_server == -1) {
+    std::cerr << who << ": Could not connect to server " << parent_name << std::endl;
+    return -1;
+  }
+
+  // Send SYN
+  connect_request request = {id, nodes, first};
+  message syn_msg(SYN, request);
+  bool sent = mq_send(qd_server, (const char *) &syn_msg, sizeof(syn_msg), 0) != -1;
+  mq_close(qd_server);
+  if (!sent) {
+    std::cerr << who << ": Could not send SYN to server" << std::endl;
+    return -1;
+  }
+
+  // Receive SYN-ACK
+  message syn_ack_msg;
+  while (syn_ack_msg.type != SYN_ACK) {
+    if (mq_receive(parent.recv, (char *) &syn_ack_msg, sizeof(syn_ack_msg), nullptr) == -1) {
+      std::cerr << who << ": Could not receive SYN-ACK" << std::endl;
+      return -1;
+    }
+  }
+  if (syn_ack_msg.data.long_val < 0) {
+    std::cerr << who << ": Server refused the connection" << std::endl;
+    return -1;
+  }
+
+  // Connect to client send
+  std::stringstream send_name_ss;
+  send_name_ss << client_server_queue_name << id;
+  if ((parent.send = mq_open(send_name_ss.str().c_str(), O_WRONLY)) == -1) {
+    std::cerr << who << ": Could not connect to client-to-server queue" << std::endl;
+    return -1;
+  }
+
+  // Send ACK
+  message ack_msg(ACK, id);
+  if (mq_send(parent.send, (const char *) &ack_msg, sizeof(ack_msg), 0) == -1) {
+    std::cerr << who << ": Could not send ACK to server" << std::endl;
+    return -1;
+  }
+
+  return syn_ack_msg.data.long_val;
+}
+
+/// Sends a message to the parent
+inline bool send_parent(parent_queue &parent, const message &msg) {
+  if (mq_send(parent.send, (const char *) &msg, sizeof(msg), 0) == -1) {
+    std::cerr << parent.who << ": Could not send " << msg << " to server" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+/// Sends the entries in use of a batch to the parent
+inline bool send_parent_batch(parent_queue &parent, const batch_message &batch) {
+  if (mq_send(parent.send, (const char *) &batch, batch_message::size(batch.count), 0) == -1) {
+    std::cerr << parent.who << ": Could not send batch of " << batch.count << " to server" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+/// Waits for the next TEMPERATURE or DONE from the parent
+inline bool receive_parent(parent_queue &parent, message &msg) {
+  do {
+    if (mq_receive(parent.recv, (char *) &msg, sizeof(msg), nullptr) == -1) {
+      std::cerr << parent.who << ": Could not receive temperature" << std::endl;
+      return false;
+    }
+  } while (msg.type != TEMPERATURE && msg.type != DONE);
+  return true;
+}
+
+#endif //CSCI411_MESSAGE_QUEUES_H
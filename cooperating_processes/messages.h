@@ -5,7 +5,11 @@
 #ifndef CSCI411_MESSAGES_H
 #define CSCI411_MESSAGES_H
 
+#include <cstddef>
+#include <cstdint>
 #include <ostream>
+#include <string>
+#include "temperature.h"
 
 // Configuration
 const char server_queue_name[] = "/temperature-server";
@@ -16,6 +20,28 @@ const long max_messages = 10;
 const long max_msg_size = 256;
 const long msg_buffer_size = max_msg_size + 10;
 
+/// How the server and clients exchange temperatures
+enum Transport {
+  MESSAGE_QUEUE, // POSIX message queues, one pair per client
+  SHARED_MEMORY  // One shared region with a slot per client (shared_memory.h)
+};
+
+/// Parses a transport name, "mqueue" or "shm"
+///
+/// \param name the name
+/// \param transport set to the transport named
+/// \return false if the name is not a transport
+inline bool parse_transport(const std::string &name, Transport &transport) {
+  if (name == "mqueue") {
+    transport = MESSAGE_QUEUE;
+  } else if (name == "shm") {
+    transport = SHARED_MEMORY;
+  } else {
+    return false;
+  }
+  return true;
+}
+
 /// Message types
 enum MessageType {
   UNKNOWN,
@@ -23,17 +49,33 @@ enum MessageType {
   SYN_ACK,
   ACK,
   DONE,
-  TEMPERATURE
+  TEMPERATURE,
+  SUBTREE, // Sent up by an aggregator instead of TEMPERATURE
+  BATCH    // Sent up by a client with many nodes instead of TEMPERATURE, as a batch_message
+};
+
+/// SYN data: who is connecting, and how many clients it speaks for
+/// A client with more than one node sends BATCH messages. An aggregator
+/// sends the number of its first client, so the parent adds up its run
+/// in that place whenever it connected.
+struct connect_request {
+  long id;
+  long nodes;
+  long first;  // -1 for the parent to number the clients
 };
 
 /// Message Data
-/// Can be long or double
+/// Can be long, double, a connect request or a subtree's temperatures
 union message_data {
   double double_val;
   long long_val;
+  connect_request request_val;
+  subtree_temps subtree_val;
 
   explicit message_data(double val) : double_val(val) {}
   explicit message_data(long val) : long_val(val) {}
+  explicit message_data(const connect_request &val) : request_val(val) {}
+  explicit message_data(const subtree_temps &val) : subtree_val(val) {}
 };
 
 /// Message
@@ -45,11 +87,13 @@ typedef struct message {
   message() : type(UNKNOWN), data(0L) {}
   message(MessageType type, double data) : type(type), data(data) {}
   message(MessageType type, long data) : type(type), data(data) {}
+  message(MessageType type, const connect_request &data) : type(type), data(data) {}
+  message(MessageType type, const subtree_temps &data) : type(type), data(data) {}
 } message;
 
 std::ostream &operator<<(std::ostream &out, const message &in) {
   switch (in.type) {
-    case SYN:out << "SYN: " << in.data.long_val;
+    case SYN:out << "SYN: " << in.data.request_val.id << " with " << in.data.request_val.nodes << " nodes";
       break;
     case SYN_ACK:out << "SYN_ACK: " << in.data.long_val;
       break;
@@ -57,6 +101,10 @@ std::ostream &operator<<(std::ostream &out, const message &in) {
       break;
     case TEMPERATURE:out << "Temperature: " << in.data.double_val;
       break;
+    case SUBTREE:out << "Subtree: " << in.data.subtree_val.clients << " clients, sum " << in.data.subtree_val.sum;
+      break;
+    case BATCH:out << "Batch";
+      break;
     case DONE: out << "Done";
       return out;
     case UNKNOWN: out << "Unknown";
@@ -66,4 +114,39 @@ std::ostream &operator<<(std::ostream &out, const message &in) {
   return out;
 }
 
+/// One node's temperature in a batch
+struct batch_entry {
+  uint32_t client;  // The client number the node was given
+  uint32_t round;   // Rounds the node finished before this one
+  double value;
+};
+
+/// Bumped whenever the layout of batch_message changes
+const uint32_t batch_version = 1;
+
+/// Largest message a queue may hold without raising /proc/sys/fs/mqueue/msgsize_max
+const size_t max_batch_bytes = 8192;
+
+/// Temperatures of many nodes in one queue message
+/// Starts with the type like a message does, so a receiver can tell them
+/// apart, and only the entries in use are sent.
+struct batch_message {
+  MessageType type;
+  uint32_t version;
+  uint32_t count;
+  batch_entry entries[(max_batch_bytes - 16) / sizeof(batch_entry)];
+
+  batch_message() : type(BATCH), version(batch_version), count(0) {}
+
+  /// Returns the bytes to send for count entries
+  static size_t size(size_t count) {
+    return offsetof(batch_message, entries) + count * sizeof(batch_entry);
+  }
+};
+
+/// Most nodes one process can send in a batch
+const size_t max_batch_entries = sizeof(batch_message::entries) / sizeof(batch_entry);
+
+static_assert(sizeof(batch_message) <= max_batch_bytes, "A batch must fit the default message size limit");
+
 #endif //CSCI411_MESSAGES_H
@@ -5,27 +5,33 @@
  * Compile with `-std=c++11 -lrt`
  */
 
+#include <chrono>
 #include <csignal>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
-#include <fcntl.h>
-#include <sys/stat.h>
-#include <mqueue.h>
 #include <sstream>
-#include <unistd.h>
+#include <string>
 #include <iomanip>
+#include <vector>
 #include "messages.h"
+#include "message_queues.h"
+#include "shared_memory.h"
+#include "temperature.h"
 
-const size_t num_clients = 4;
-mqd_t qd_server;
-mqd_t qd_client_send[num_clients], qd_client_recv[num_clients];
+size_t num_clients = 4;
+Transport transport = MESSAGE_QUEUE;
+bool asynchronous = false;
+shared_header *shared = nullptr;
+child_queues children;
 
 /// Close all queues on quit
 void quit(int signal = 0) {
-  mq_close(qd_server);
-  for (mqd_t client_send_mq : qd_client_send) {
-    mq_close(client_send_mq);
+  if (shared) {
+    shared_memory_detach(shared);
+    shm_unlink(shared_memory_name);
   }
+  close_children(children);
 
   if (signal == SIGINT || signal == 0) {
     exit(0);
@@ -34,158 +40,215 @@ void quit(int signal = 0) {
   }
 }
 
-/// Receives values from each client and sends the central temp
-/// Temperature values are modified/updated
+/// Waits for every client to write its slot, then reads the slots
 ///
-/// \param central_temp the central temperature
-/// \param external_temps external temperature values
-void iterate(double &central_temp, double external_temps[num_clients]) {
-  double sum = 0.0;
+/// \param subtrees set to the clients' temperatures
+void receive_shared_temperatures(std::vector<subtree_temps> &subtrees) {
+  shared->wait_for_clients();
+  seqlock_slot *slots = shared->slots();
   for (size_t i = 0; i < num_clients; ++i) {
-    message client_message(UNKNOWN, 0.0);
-    while (client_message.type != TEMPERATURE) {
-      if (mq_receive(qd_client_recv[i], (char *) &client_message, sizeof(client_message), nullptr)
-          == -1) {
-        std::cerr << "Server: Could not receive temperature from client " << i << std::endl;
-        quit();
-      }
-    }
+    subtrees[i] = single_client(slots[i].read());
+  }
+}
 
-    sum += client_message.data.double_val;
-    external_temps[i] = client_message.data.double_val;
+/// Publishes the central temperature and starts the next round
+void send_shared_central(double central_temp) {
+  shared->central.write(central_temp);
+  if (asynchronous) {
+    shared->publish();
+  } else {
+    shared->next_round();
   }
+}
 
-  central_temp = (2 * central_temp + sum) / 6;
+/// Tells the clients to stop once they finished the current round
+void send_shared_done() {
+  if (!asynchronous) shared->wait_for_clients();
+  shared->done.store(1, std::memory_order_relaxed);
+  if (asynchronous) {
+    shared->publish();
+  } else {
+    shared->next_round();
+  }
+}
 
-  // Send current temperature to clients
-  std::stringstream log_msg;
-  log_msg << "Server: Sending " << std::setprecision(4) << std::fixed << central_temp;
-  std::cout << log_msg.str() << std::endl;
+/// Asynchronous mode: updates the central temperature from the latest
+/// client temperatures, without waiting for rounds, until every client
+/// is quiet on it. A new central temperature is only sent when it moved
+/// by more than half the tolerance.
+///
+/// \param central_temp the central temperature
+/// \return the number of central temperatures sent
+size_t iterate_async(double &central_temp) {
+  size_t sent = 0;
+  seqlock_slot *slots = shared->slots();
+  while (!shared->all_quiet()) {
+    uint32_t seen = shared->arrived.value.load(std::memory_order_acquire);
+
+    double sum = 0.0;
+    for (size_t i = 0; i < num_clients; ++i) {
+      sum += slots[i].read();
+    }
 
-  message central_temp_msg(TEMPERATURE, central_temp);
-  for (mqd_t &client_send_mq : qd_client_send) {
-    if (mq_send(client_send_mq, (const char *) &central_temp_msg, sizeof(central_temp_msg), 0) == -1) {
-      std::cerr << "Server: Could not receive temperature to client" << std::endl;
-      quit();
+    double next_temp = apply_rule(server_rule, central_temp, sum, num_clients);
+    if (std::abs(next_temp - central_temp) > stable_tolerance / 2) {
+      central_temp = next_temp;
+
+      std::stringstream log_msg;
+      log_msg << "Server: Sending " << std::setprecision(4) << std::fixed << central_temp;
+      std::cout << log_msg.str() << std::endl;
+
+      send_shared_central(central_temp);
+      ++sent;
+    } else if (!shared->all_quiet()) {
+      // The last client to go quiet changes arrived afterwards, so
+      // checking again after reading it cannot miss the end
+      shared->arrived.wait_change(seen);
     }
   }
+  return sent;
 }
 
-/// Returns false if the difference in external temperatures are < 0.0001
+/// Receives values from each client and sends the central temp
+/// Temperature values are modified/updated
+///
+/// Temperatures are added up in client order whatever order they
+/// arrived in, so the result is deterministic for a given tree. An
+/// aggregator's clients count as the run of clients in its place, by the
+/// first client it sent with SYN, but it adds them up first, which may
+/// round differently from a flat run; tree_check.sh checks that both
+/// still agree on what is printed.
 ///
-/// \param external_temps the external temperatures
-/// \return If the temperatures are stable
-bool is_stable(const double external_temps[num_clients]) {
-  double val = external_temps[0];
-  for (size_t i = 1; i < num_clients; ++i) {
-    if (std::abs(external_temps[i] - val) > 0.0001)
-      return false;
-
-    val = external_temps[i];
+/// \param central_temp the central temperature
+/// \param subtrees what each client or aggregator reported
+/// \return If the temperatures were stable
+bool iterate(double &central_temp, std::vector<subtree_temps> &subtrees) {
+  if (transport == SHARED_MEMORY) {
+    receive_shared_temperatures(subtrees);
+  } else if (!receive_subtrees(children, subtrees)) {
+    quit();
   }
 
-  return true;
-}
-
-int main() {
-  signal(SIGINT, &quit);
+  subtree_temps total = combine(subtrees.data(), subtrees.size());
 
-  std::cout << "Server: Started!\n";
+  // With four clients this is (2 * central + sum) / 6
+  central_temp = apply_rule(server_rule, central_temp, total.sum, total.clients);
 
-  mq_attr attr = {};
-  attr.mq_flags = 0;
-  attr.mq_maxmsg = max_messages;
-  attr.mq_msgsize = sizeof(message);
-  attr.mq_curmsgs = 0;
+  // Send current temperature to clients
+  std::stringstream log_msg;
+  log_msg << "Server: Sending " << std::setprecision(4) << std::fixed << central_temp;
+  std::cout << log_msg.str() << std::endl;
 
-  if ((qd_server = mq_open(server_queue_name, O_RDONLY | O_CREAT, queue_permissions, &attr)) == -1) {
-    std::cerr << "Server: Could not create main message queue" << std::endl;
+  if (transport == SHARED_MEMORY) {
+    send_shared_central(central_temp);
+  } else if (!send_children(children, message(TEMPERATURE, central_temp))) {
     quit();
   }
 
-  double central_temperature;
-  double external_temperatures[num_clients];
+  return total.stable != 0;
+}
 
-  long client_number = 0;
+void print_usage() {
+  std::cout << "Usage: server [NUM_CLIENTS] [TRANSPORT] [MODE] [NAME]\n"
+            << "    NUM_CLIENTS - The number of clients, or aggregators, to wait for (default 4);\n"
+            << "                  a client running many nodes counts once\n"
+            << "    TRANSPORT - mqueue or shm, which clients must also use (default mqueue)\n"
+            << "    MODE - sync, rounds in lockstep, or async, which needs shm (default sync)\n"
+            << "    NAME - With mqueue, the queue clients connect to (default " << server_queue_name << ")\n"
+            << "Over mqueue each client uses two message queues; more than about 125 clients\n"
+            << "needs a higher /proc/sys/fs/mqueue/queues_max\n";
+}
 
-  // Connect to four clients
-  while (client_number < num_clients) {
-    message client_message;
-    while (client_message.type != SYN) {
-      if (mq_receive(qd_server, (char *) &client_message, sizeof(client_message), nullptr) == -1) {
-        std::cerr << "Server: Could not receive SYN" << std::endl;
-        quit();
-      }
-    }
+int main(int argc, char *argv[]) {
+  std::string listen_name = server_queue_name;
 
-    std::cout << "Server: Client #" << client_number << " connecting with id " << client_message.data.long_val
-              << std::endl;
+  if (argc > 5) {
+    std::cerr << "Error: Too many arguments!\n\n";
+    print_usage();
+    return 1;
+  }
 
-    // Connect to client
-    std::stringstream client_send_queue_name;
-    client_send_queue_name << server_client_queue_name << client_message.data.long_val;
-    if ((qd_client_send[client_number] = mq_open(client_send_queue_name.str().c_str(), O_WRONLY)) == 1) {
-      std::cerr << "Server: Not able to open client queue: " << client_send_queue_name.str() << std::endl;
-      continue;
+  // Parse arguments
+  try {
+    if (argc >= 2) {
+      long clients = std::stol(argv[1]);
+      if (clients <= 0 || clients > UINT32_MAX) throw std::exception();
+      num_clients = static_cast<size_t>(clients);
     }
-
-    // Create a client recv queue
-    std::stringstream client_recv_queue_name;
-    client_recv_queue_name << client_server_queue_name << client_message.data.long_val;
-    if ((qd_client_recv[client_number] =
-             mq_open(client_recv_queue_name.str().c_str(), O_RDONLY | O_CREAT, queue_permissions, &attr)) == -1) {
-      std::cerr << "Server: Could not create server to client queue: " << client_recv_queue_name.str() << std::endl;
-      quit();
+    if (argc >= 3 && !parse_transport(argv[2], transport)) throw std::exception();
+    if (argc >= 4) {
+      std::string mode = argv[3];
+      if (mode != "sync" && mode != "async") throw std::exception();
+      asynchronous = mode == "async";
+      if (asynchronous && transport != SHARED_MEMORY) throw std::exception();
     }
-
-    // Send client SYN-ACK
-    message syn_ack_msg(SYN_ACK, client_number);
-    if (mq_send(qd_client_send[client_number], (const char *) &syn_ack_msg, sizeof(syn_ack_msg), 0) == -1) {
-      std::cerr << "Server: Not able to send SYN-ACK to client: " << client_send_queue_name.str() << std::endl;
-
-      // Close server-to-client queue
-      if (mq_close(qd_client_send[client_number]) == -1) {
-        std::cerr << "Server: Error closing server-to-client queue: " << client_recv_queue_name.str() << std::endl;
-        quit();
-      }
-      continue;
+    if (argc == 5) {
+      listen_name = argv[4];
+      if (transport != MESSAGE_QUEUE || listen_name.size() < 2 || listen_name[0] != '/') throw std::exception();
     }
+  } catch (std::exception &e) {
+    std::cerr << "Error: Invalid arguments!\n\n";
+    print_usage();
+    return 1;
+  }
+
+  signal(SIGINT, &quit);
+  raise_queue_limits();
 
-    while (client_message.type != ACK) {
-      // Receive ACK
-      if (mq_receive(qd_client_recv[client_number], (char *) &client_message, sizeof(client_message), nullptr)
-          == -1) {
-        std::cerr << "Server: Could not receive ACK: " << client_recv_queue_name.str() << std::endl;
-
-        // Close server-to-client queue
-        if (mq_close(qd_client_send[client_number]) == -1) {
-          std::cerr << "Server: Error closing server-to-client queue: " << client_recv_queue_name.str() << std::endl;
-          quit();
-        }
-        continue;
-      }
+  std::cout << "Server: Started!\n";
+
+  if (transport == SHARED_MEMORY) {
+    if ((shared = shared_memory_create(num_clients, asynchronous)) == nullptr) {
+      std::cerr << "Server: Could not create shared memory" << std::endl;
+      quit();
     }
+    std::cout << "Server: Waiting for " << num_clients << " clients" << std::endl;
 
-    ++client_number;
+    // Clients join by writing their first temperature
+    shared->wait_for_clients();
+  } else {
+    // Connect to the clients
+    if (!open_children(children, "Server", listen_name, num_clients) || !connect_children(children)) {
+      quit();
+    }
   }
 
+  double central_temperature = 0.0;
+  std::vector<subtree_temps> external_temperatures(num_clients);
 
   // Send/receive until stable
-  iterate(central_temperature, external_temperatures);
-  while (!is_stable(external_temperatures)) {
-    iterate(central_temperature, external_temperatures);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  bool stable = iterate(central_temperature, external_temperatures);
+  size_t rounds = 1;
+  if (asynchronous) {
+    rounds += iterate_async(central_temperature);
+  } else {
+    while (!stable) {
+      stable = iterate(central_temperature, external_temperatures);
+      ++rounds;
+    }
   }
+  double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
 
   // Send DONE
   std::cout << "Server: Sending DONE" << std::endl;
+  if (transport == SHARED_MEMORY) {
+    send_shared_done();
+  } else if (!send_children(children, message(DONE, 0L))) {
+    quit();
+  }
 
-  message done_msg(DONE, 0L);
-  for (mqd_t &client_send_mq : qd_client_send) {
-    if (mq_send(client_send_mq, (const char *) &done_msg, sizeof(done_msg), 0) == -1) {
-      std::cerr << "Server: Could not receive temperature to client" << std::endl;
-      quit();
-    }
+  // Time to reach the tolerance once every client joined, to compare the modes
+  if (asynchronous) {
+    std::cout << "Server: All clients quiet after " << rounds << " central temperatures, ";
+  } else {
+    std::cout << "Server: Stable after " << rounds << " rounds, ";
   }
+  std::cout << std::setprecision(2) << std::fixed << elapsed << " us" << std::endl;
+
+  // Every digit, to compare against diffusion star:N
+  std::cout << "Server: Central temperature " << std::defaultfloat << std::setprecision(17) << central_temperature
+            << std::endl;
 
   quit(0);
 }
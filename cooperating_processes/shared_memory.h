@@ -0,0 +1,262 @@
+//
+// Created by Peter on 10/17/2026.
+//
+
+#ifndef CSCI411_SHARED_MEMORY_H
+#define CSCI411_SHARED_MEMORY_H
+
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <thread>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Shared memory transport
+// The server and the clients map one region: a header, then one slot per
+// client. Each round a client writes its temperature to its own slot and
+// arrives at a barrier; the last one to arrive wakes the server, which
+// reads every slot, writes the central temperature and starts the next
+// round. Nothing goes through the kernel unless a process has to sleep.
+//
+// In asynchronous mode only the first round is lockstep. After it the
+// server republishes the central temperature whenever the latest client
+// temperatures move it by more than half the tolerance, and each client
+// keeps moving toward the latest central temperature without waiting.
+// A client within half the tolerance of it goes quiet until it changes.
+// Quiet clients are counted per central temperature, so once all of them
+// are quiet on the current one, nothing can change anymore and the
+// server stops, without scanning for stability.
+
+const char shared_memory_name[] = "/temperature-shm";
+const size_t cache_line_size = 64;
+const uint32_t shared_memory_ready = 0x54454d50;
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2,
+              "Shared memory atomics must be lock-free to work across processes");
+
+/// A 32-bit counter other processes can sleep on with a futex
+/// Sleepers are counted, so waking costs no system call while nobody sleeps
+struct futex_word {
+  std::atomic<uint32_t> value;
+  std::atomic<uint32_t> sleepers;
+
+  futex_word() : value(0), sleepers(0) {}
+
+  /// Waits until value is no longer old, spinning briefly first when
+  /// another CPU can change it in the meantime
+  ///
+  /// \param old the value to wait out
+  /// \return the new value
+  uint32_t wait_change(uint32_t old) {
+    static const int spin_limit = std::thread::hardware_concurrency() > 1 ? 20000 : 0;
+
+    uint32_t now;
+    for (int spin = 0; spin < spin_limit; ++spin) {
+      if ((now = value.load(std::memory_order_acquire)) != old) return now;
+    }
+
+    while ((now = value.load(std::memory_order_acquire)) == old) {
+      sleepers.fetch_add(1);
+      // Returns at once if value already changed
+      syscall(SYS_futex, &value, FUTEX_WAIT, old, nullptr, nullptr, 0);
+      sleepers.fetch_sub(1);
+    }
+    return now;
+  }
+
+  /// Wakes every process sleeping on the word
+  /// Call after changing value
+  void wake_all() {
+    if (sleepers.load() > 0) {
+      syscall(SYS_futex, &value, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+    }
+  }
+};
+
+/// A temperature with one writer, published with a seqlock
+/// Readers retry while the sequence is odd or changes under them, so they
+/// never see half a write. One slot per cache line, so clients writing
+/// their own slots do not slow each other down.
+struct alignas(cache_line_size) seqlock_slot {
+  std::atomic<uint32_t> seq;
+  std::atomic<double> value;
+
+  seqlock_slot() : seq(0), value(0.0) {}
+
+  /// Publishes a value; only one process may write a slot
+  void write(double val) {
+    uint32_t start = seq.load(std::memory_order_relaxed);
+    seq.store(start + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    value.store(val, std::memory_order_relaxed);
+    seq.store(start + 2, std::memory_order_release);
+  }
+
+  /// Returns the last published value
+  double read() const {
+    while (true) {
+      uint32_t start = seq.load(std::memory_order_acquire);
+      double val = value.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (!(start & 1) && seq.load(std::memory_order_relaxed) == start) return val;
+    }
+  }
+};
+
+/// The start of the shared region; the client slots follow it
+struct alignas(cache_line_size) shared_header {
+  std::atomic<uint32_t> ready;        // shared_memory_ready once the server set up the region
+  uint32_t num_clients;
+  std::atomic<uint32_t> next_client;  // Client numbers handed out so far
+  std::atomic<uint32_t> done;         // Set by the server before the last round starts
+  uint32_t asynchronous;              // 1 if clients stop waiting for rounds after the first
+
+  alignas(cache_line_size) futex_word arrived;  // Clients that wrote their temperature this round
+  alignas(cache_line_size) futex_word round;    // Rounds the server has started
+  seqlock_slot central;
+  std::atomic<uint64_t> quiet;  // Asynchronous: the round in the high half, clients quiet in it in the low half
+
+  shared_header(uint32_t num_clients, bool asynchronous)
+      : ready(0), num_clients(num_clients), next_client(0), done(0), asynchronous(asynchronous), quiet(0) {}
+
+  seqlock_slot *slots() {
+    return reinterpret_cast<seqlock_slot *>(this + 1);
+  }
+
+  /// Called by a client after writing its slot; the last one wakes the server
+  void arrive() {
+    if (arrived.value.fetch_add(1, std::memory_order_acq_rel) + 1 == num_clients) {
+      arrived.wake_all();
+    }
+  }
+
+  /// Called by the server; waits until every client wrote its slot
+  void wait_for_clients() {
+    uint32_t count = arrived.value.load(std::memory_order_acquire);
+    while (count < num_clients) count = arrived.wait_change(count);
+  }
+
+  /// Called by the server after writing the central temperature;
+  /// releases the clients into the next round
+  void next_round() {
+    arrived.value.store(0, std::memory_order_relaxed);
+    round.value.fetch_add(1, std::memory_order_release);
+    round.wake_all();
+  }
+
+  /// Asynchronous: called by the server after writing a new central
+  /// temperature; no client is quiet on it yet
+  void publish() {
+    uint32_t next = round.value.load(std::memory_order_relaxed) + 1;
+    quiet.store(static_cast<uint64_t>(next) << 32, std::memory_order_relaxed);
+    round.value.store(next, std::memory_order_release);
+    round.wake_all();
+  }
+
+  /// Asynchronous: reads the central temperature and the round it is from
+  double read_central(uint32_t &version) {
+    while (true) {
+      version = round.value.load(std::memory_order_acquire);
+      double central_temp = central.read();
+      if (round.value.load(std::memory_order_acquire) == version) return central_temp;
+    }
+  }
+
+  /// Asynchronous: called by a client that settled on the central
+  /// temperature of a round
+  ///
+  /// \return false if the server published a newer one meanwhile
+  bool go_quiet(uint32_t version) {
+    uint64_t current = quiet.load(std::memory_order_relaxed);
+    do {
+      if (current >> 32 != version) return false;
+    } while (!quiet.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel));
+    return true;
+  }
+
+  /// Asynchronous: returns true once every client is quiet on the latest
+  /// central temperature
+  bool all_quiet() {
+    uint64_t version = round.value.load(std::memory_order_relaxed);
+    return quiet.load(std::memory_order_acquire) == (version << 32 | num_clients);
+  }
+
+  /// Asynchronous: called by a client after writing its slot, so the
+  /// server looks at the slots again
+  void changed() {
+    arrived.value.fetch_add(1, std::memory_order_release);
+    arrived.wake_all();
+  }
+};
+
+/// Returns the size of the region for a number of clients
+inline size_t shared_memory_size(size_t num_clients) {
+  return sizeof(shared_header) + num_clients * sizeof(seqlock_slot);
+}
+
+/// Creates the shared region, replacing one left over from an earlier run
+///
+/// \param num_clients the number of client slots
+/// \param asynchronous if clients stop waiting for rounds after the first
+/// \return the region, or nullptr if it could not be created
+inline shared_header *shared_memory_create(size_t num_clients, bool asynchronous) {
+  shm_unlink(shared_memory_name);
+  int fd = shm_open(shared_memory_name, O_RDWR | O_CREAT | O_EXCL, 0660);
+  if (fd == -1) return nullptr;
+
+  size_t size = shared_memory_size(num_clients);
+  void *region = MAP_FAILED;
+  if (ftruncate(fd, static_cast<off_t>(size)) == 0) {
+    region = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (region == MAP_FAILED) {
+    shm_unlink(shared_memory_name);
+    return nullptr;
+  }
+
+  shared_header *header = new(region) shared_header(static_cast<uint32_t>(num_clients), asynchronous);
+  for (size_t i = 0; i < num_clients; ++i) {
+    new(&header->slots()[i]) seqlock_slot();
+  }
+  header->ready.store(shared_memory_ready, std::memory_order_release);
+  return header;
+}
+
+/// Maps the region a server created
+///
+/// \return the region, or nullptr if there is no server ready
+inline shared_header *shared_memory_attach() {
+  int fd = shm_open(shared_memory_name, O_RDWR, 0);
+  if (fd == -1) return nullptr;
+
+  struct stat info = {};
+  void *region = MAP_FAILED;
+  if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(shared_header)) {
+    region = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (region == MAP_FAILED) return nullptr;
+
+  shared_header *header = static_cast<shared_header *>(region);
+  if (header->ready.load(std::memory_order_acquire) != shared_memory_ready
+      || static_cast<size_t>(info.st_size) < shared_memory_size(header->num_clients)) {
+    munmap(region, static_cast<size_t>(info.st_size));
+    return nullptr;
+  }
+  return header;
+}
+
+/// Unmaps the region
+inline void shared_memory_detach(shared_header *header) {
+  if (header) munmap(header, shared_memory_size(header->num_clients));
+}
+
+#endif //CSCI411_SHARED_MEMORY_H
@@ -0,0 +1,37 @@
+#!/bin/bash
+#
+# Peter Nguyen
+# CSCI 411 - Cooperating Processes - Diffusion check
+#
+# Runs CLIENTS clients against the server, then the diffusion engine on a
+# star of as many clients, and checks that both take the same number of
+# rounds to the same central temperature, to every digit.
+#
+# Usage: star_check.sh CLIENTS [BUILD_DIR]
+
+if [ $# -lt 1 ] || [ "$1" -le 0 ]; then
+  echo "Usage: star_check.sh CLIENTS [BUILD_DIR]"
+  echo "    CLIENTS - The number of clients"
+  echo "    BUILD_DIR - Where server, client and diffusion are (default .)"
+  exit 1
+fi
+
+clients=$1
+bin=${2:-.}
+tree=$(dirname "$0")/tree.sh
+
+# With FAN_IN at least CLIENTS the tree has no aggregators
+server=$("$tree" "$clients" "$clients" "$bin")
+server_rounds=$(sed -n 's/^Server: Stable after \([0-9]*\) rounds.*/\1/p' <<< "$server")
+server_temp=$(sed -n 's/^Server: Central temperature //p' <<< "$server")
+
+diffusion=$("$bin/diffusion" "star:$clients" 1)
+diffusion_rounds=$(sed -n 's/^Diffusion: Stable after \([0-9]*\) rounds.*/\1/p' <<< "$diffusion")
+diffusion_temp=$(sed -n 's/^Diffusion: Node 0 exactly //p' <<< "$diffusion")
+
+echo "Server: $server_rounds rounds, $server_temp"
+echo "Diffusion: $diffusion_rounds rounds, $diffusion_temp"
+if [ -z "$server_temp" ] || [ "$server_rounds" != "$diffusion_rounds" ] || [ "$server_temp" != "$diffusion_temp" ]; then
+  echo "Error: The diffusion engine did not match the server!"
+  exit 1
+fi
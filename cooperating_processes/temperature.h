@@ -0,0 +1,89 @@
+//
+// Created by Peter on 10/17/2026.
+//
+
+#ifndef CSCI411_TEMPERATURE_H
+#define CSCI411_TEMPERATURE_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// The model, shared by the server, the clients and the diffusion engine
+
+/// Temperatures this close to each other count as stable
+const double stable_tolerance = 0.0001;
+
+/// How a node moves toward its neighbors:
+/// next = (self * temp + neighbor * sum of neighbors) / (self + neighbor * degree)
+struct update_rule {
+  double self;
+  double neighbor;
+};
+
+/// The central temperature, (2 * central + sum) / (2 + clients)
+const update_rule server_rule = {2, 1};
+
+/// A client's temperature, (3 * current + 2 * central) / 5
+const update_rule client_rule = {3, 2};
+
+/// Applies a rule to a node
+///
+/// \param rule the node's rule
+/// \param temp the node's temperature
+/// \param sum the sum of its neighbors' temperatures
+/// \param degree the number of neighbors
+/// \return the node's next temperature
+inline double apply_rule(const update_rule &rule, double temp, double sum, size_t degree) {
+  return (rule.self * temp + rule.neighbor * sum) / (rule.self + rule.neighbor * static_cast<double>(degree));
+}
+
+/// Converts a client number to the starting temp
+/// The four starting temps repeat for every four clients
+inline double client_number_to_temp(long number) {
+  switch (number % 4) {
+    case 0: return 100;
+    case 1: return 22;
+    case 2: return 50;
+    case 3: return 40;
+    default: return 0;
+  }
+}
+
+/// What a run of clients reports each round, so a server can update and
+/// check stability without seeing every temperature
+struct subtree_temps {
+  double sum;          // The clients' temperatures added up in order
+  double first, last;  // The first and last client's temperature
+  uint32_t clients;
+  uint32_t stable;     // 1 if adjacent clients in the run are within tolerance
+};
+
+/// Returns the report for a single client
+inline subtree_temps single_client(double temp) {
+  subtree_temps single = {temp, temp, temp, 1, 1};
+  return single;
+}
+
+/// Joins runs of clients, in order, into one
+/// Each run's sum is added as a whole, so how the clients are grouped
+/// into runs can change the rounding of the total.
+/// For single clients this adds up the temperatures and checks that
+/// adjacent ones are within tolerance, as the server always has.
+///
+/// \param parts the runs
+/// \param count the number of runs, at least one
+/// \return the joined run
+inline subtree_temps combine(const subtree_temps *parts, size_t count) {
+  subtree_temps total = {0.0, parts[0].first, parts[count - 1].last, 0, 1};
+  for (size_t i = 0; i < count; ++i) {
+    total.sum += parts[i].sum;
+    total.clients += parts[i].clients;
+    if (!parts[i].stable || (i > 0 && std::abs(parts[i].first - parts[i - 1].last) > stable_tolerance)) {
+      total.stable = 0;
+    }
+  }
+  return total;
+}
+
+#endif //CSCI411_TEMPERATURE_H
@@ -0,0 +1,74 @@
+#!/bin/bash
+#
+# Peter Nguyen
+# CSCI 411 - Cooperating Processes - Aggregator tree
+#
+# Runs the server with CLIENTS clients under a tree of aggregators, each
+# with at most FAN_IN children, and waits for it to finish.
+# Queue names carry this script's pid, so runs side by side do not meet,
+# and every process waits for its parent's queue, so no start order is needed.
+# Every connection takes two message queues, so large trees need a
+# higher /proc/sys/fs/mqueue/queues_max, and the queues of all processes
+# together count against one user's `ulimit -q`.
+#
+# Usage: tree.sh CLIENTS FAN_IN [BUILD_DIR]
+
+if [ $# -lt 2 ] || [ "$1" -le 0 ] || [ "$2" -lt 2 ]; then
+  echo "Usage: tree.sh CLIENTS FAN_IN [BUILD_DIR]"
+  echo "    CLIENTS - The number of clients"
+  echo "    FAN_IN - The most children of any aggregator or the server, at least 2"
+  echo "    BUILD_DIR - Where server, aggregator and client are (default .)"
+  exit 1
+fi
+
+clients=$1
+fan_in=$2
+bin=${3:-.}
+prefix=/temperature-$$
+
+# Raise the limits for every process in the tree, where allowed
+ulimit -n "$(ulimit -Hn)" -q "$(ulimit -Hq)" 2> /dev/null
+
+# The number of aggregators on each level, bottom up, until the server
+# can take the top level as its children
+level=0
+below=$clients
+declare -a parents
+while [ "$below" -gt "$fan_in" ]; do
+  count=$(( (below + fan_in - 1) / fan_in ))
+  parents[$level]=$count
+  below=$count
+  level=$((level + 1))
+done
+levels=$level
+
+"$bin/server" "$below" mqueue sync "$prefix-server" &
+server_pid=$!
+
+# Aggregator j of a level takes children j * FAN_IN onward of the level below,
+# so the clients are numbered as if they connected to the server directly
+below=$clients
+for ((level = 0; level < levels; ++level)); do
+  count=${parents[$level]}
+  for ((j = 0; j < count; ++j)); do
+    children=$(( below - j * fan_in < fan_in ? below - j * fan_in : fan_in ))
+    if [ $((level + 1)) -lt "$levels" ]; then
+      parent="$prefix-aggregator-$((level + 1))-$((j / fan_in))"
+    else
+      parent="$prefix-server"
+    fi
+    "$bin/aggregator" "$children" "$prefix-aggregator-$level-$j" "$parent" $((j * fan_in)) > /dev/null &
+  done
+  below=$count
+done
+
+for ((i = 0; i < clients; ++i)); do
+  if [ "$levels" -gt 0 ]; then
+    "$bin/client" mqueue "$prefix-aggregator-0-$((i / fan_in))" > /dev/null &
+  else
+    "$bin/client" mqueue "$prefix-server" > /dev/null &
+  fi
+done
+
+wait $server_pid
+wait
@@ -0,0 +1,44 @@
+#!/bin/bash
+#
+# Peter Nguyen
+# CSCI 411 - Cooperating Processes - Aggregator tree check
+#
+# Runs CLIENTS clients straight into the server, then again under a tree
+# of aggregators with at most FAN_IN children, and checks that both runs
+# take the same number of rounds to a final temperature that prints the
+# same. Aggregators add up their own clients first, so the sums may round
+# differently in the last bits; anything printed must still agree.
+#
+# Usage: tree_check.sh CLIENTS FAN_IN [BUILD_DIR]
+
+if [ $# -lt 2 ] || [ "$1" -le 0 ] || [ "$2" -lt 2 ]; then
+  echo "Usage: tree_check.sh CLIENTS FAN_IN [BUILD_DIR]"
+  echo "    CLIENTS - The number of clients"
+  echo "    FAN_IN - The most children of any aggregator or the server, at least 2"
+  echo "    BUILD_DIR - Where server, aggregator and client are (default .)"
+  exit 1
+fi
+
+clients=$1
+fan_in=$2
+bin=${3:-.}
+tree=$(dirname "$0")/tree.sh
+
+# Prints the round count and the last temperature the server sent
+result() {
+  local rounds temp
+  rounds=$(sed -n 's/^Server: Stable after \([0-9]*\) rounds.*/\1/p' <<< "$1")
+  temp=$(grep '^Server: Sending [0-9.-]' <<< "$1" | tail -n 1 | cut -d ' ' -f 3)
+  echo "$rounds rounds, $temp"
+}
+
+# With FAN_IN at least CLIENTS the tree has no aggregators
+flat=$(result "$("$tree" "$clients" "$clients" "$bin")")
+aggregated=$(result "$("$tree" "$clients" "$fan_in" "$bin")")
+
+echo "Flat: $flat"
+echo "Tree: $aggregated"
+if [ "$flat" != "$aggregated" ] || [ "$flat" = " rounds, " ]; then
+  echo "Error: The tree did not match the flat run!"
+  exit 1
+fi
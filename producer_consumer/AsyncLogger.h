@@ -0,0 +1,218 @@
+//
+// Created by Peter on 10/17/2026.
+//
+
+#ifndef CSCI411_ASYNCLOGGER_H
+#define CSCI411_ASYNCLOGGER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "RingBuffer.h"
+#include "SpscRingBuffer.h"
+
+/// Log levels, lowest first
+enum LogLevel { LOG_DEBUG, LOG_INFO, LOG_WARN, LOG_ERROR, LOG_OFF };
+
+/// What a log record is about
+enum LogEvent { PRODUCED, CONSUMED, PRODUCE_FAILED, CONSUME_FAILED };
+
+/// One fixed-size binary log record. Formatting waits for the flusher.
+struct LogRecord {
+  int64_t value;
+  uint32_t worker;
+  uint8_t event;
+  uint8_t level;
+  bool hasValue;
+};
+
+/// Logger that keeps formatting and I/O off the worker threads.
+/// Every worker writes binary records into its own lock-free Channel, and a
+/// background thread drains the channels, formats the records and writes
+/// them in large batches. Records below the level are dropped before they
+/// are built, and only one in every sampleEvery records below LOG_WARN is
+/// kept. A full channel drops the record instead of blocking the worker.
+class AsyncLogger {
+ public:
+  /// A single worker's record buffer. Only its own worker may log to it.
+  class Channel : public CacheAligned {
+    friend class AsyncLogger;
+
+   private:
+    const AsyncLogger &logger;
+    RingCore<LogRecord, Spsc> records;
+    uint64_t seen = 0;
+    std::atomic<uint64_t> dropped;
+
+    Channel(const AsyncLogger &logger, unsigned int size) : logger(logger), records(size), dropped(0) {};
+
+   public:
+    /// Logs an event, about an item if it has an integral value
+    ///
+    /// \param worker the producer or consumer id
+    template<typename T>
+    void log(LogLevel level, LogEvent event, uint32_t worker, const T &item) {
+      if (!keep(level)) return;
+
+      LogRecord record = {to_value(item), worker, static_cast<uint8_t>(event), static_cast<uint8_t>(level),
+                          std::is_integral<T>::value};
+      if (!records.emplace(record)) dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// Logs an event that is not about any item
+    void log(LogLevel level, LogEvent event, uint32_t worker) {
+      if (!keep(level)) return;
+
+      LogRecord record = {0, worker, static_cast<uint8_t>(event), static_cast<uint8_t>(level), false};
+      if (!records.emplace(record)) dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+   private:
+    /// Applies the level and the sampling rate
+    bool keep(LogLevel level) {
+      if (level < logger.level.load(std::memory_order_relaxed)) return false;
+      if (level >= LOG_WARN) return true;
+      return ++seen % logger.sampleEvery.load(std::memory_order_relaxed) == 0;
+    }
+
+    template<typename T>
+    static int64_t to_value(const T &item, typename std::enable_if<std::is_integral<T>::value>::type * = nullptr) {
+      return static_cast<int64_t>(item);
+    }
+
+    template<typename T>
+    static int64_t to_value(const T &, typename std::enable_if<!std::is_integral<T>::value>::type * = nullptr) {
+      return 0;
+    }
+  };
+
+ private:
+  static const size_t BATCH_SIZE = 256;
+
+  std::atomic<int> level;
+  std::atomic<unsigned int> sampleEvery;
+  const unsigned int channelSize;
+  const std::chrono::milliseconds flushInterval;
+
+  std::mutex channelsMutex;
+  std::vector<std::unique_ptr<Channel>> channels;
+  std::atomic<bool> running;
+  std::thread flusher;
+
+  /// Appends the text of one record
+  static void format(const LogRecord &record, std::string &out) {
+    switch (record.event) {
+      case PRODUCED:out += "Producer #" + std::to_string(record.worker) + ": Produced item";
+        break;
+      case CONSUMED:out += "Consumer #" + std::to_string(record.worker) + ": Consumed item";
+        break;
+      case PRODUCE_FAILED:out += "Producer #" + std::to_string(record.worker) + ": Error producing value";
+        break;
+      case CONSUME_FAILED:out += "Consumer #" + std::to_string(record.worker) + ": Error trying to consume item";
+        break;
+      default:out += "Worker #" + std::to_string(record.worker) + ": Unknown event";
+        break;
+    }
+    if (record.hasValue) out += " " + std::to_string(record.value);
+    out += '\n';
+  }
+
+  /// Drains every channel once and writes what it found
+  ///
+  /// \return the number of records written
+  size_t drain() {
+    std::vector<Channel *> snapshot;
+    {
+      std::lock_guard<std::mutex> lock(channelsMutex);
+      for (const std::unique_ptr<Channel> &channel : channels) snapshot.push_back(channel.get());
+    }
+
+    LogRecord batch[BATCH_SIZE];
+    std::string out, err;
+    size_t written = 0;
+
+    for (Channel *channel : snapshot) {
+      size_t count;
+      while ((count = channel->records.pop_bulk(batch, BATCH_SIZE)) > 0) {
+        for (size_t i = 0; i < count; ++i) format(batch[i], batch[i].level >= LOG_WARN ? err : out);
+        written += count;
+      }
+
+      uint64_t dropped = channel->dropped.exchange(0, std::memory_order_relaxed);
+      if (dropped > 0) err += "Logger: Dropped " + std::to_string(dropped) + " records\n";
+    }
+
+    if (!out.empty()) std::cout.write(out.data(), static_cast<std::streamsize>(out.size())).flush();
+    if (!err.empty()) std::cerr.write(err.data(), static_cast<std::streamsize>(err.size())).flush();
+    return written;
+  }
+
+  /// Background loop: drains the channels, sleeping whenever they run dry
+  void flush_loop() {
+    while (running.load(std::memory_order_acquire)) {
+      if (drain() == 0) std::this_thread::sleep_for(flushInterval);
+    }
+    drain();
+  }
+
+ public:
+  /// Creates a stopped logger
+  ///
+  /// \param level the lowest level kept
+  /// \param sampleEvery keep one in this many records below LOG_WARN
+  /// \param channelSize the number of records each worker can have waiting
+  /// \param flushInterval how long the flusher sleeps when there is nothing to write
+  explicit AsyncLogger(LogLevel level = LOG_INFO, unsigned int sampleEvery = 1, unsigned int channelSize = 4096,
+                       std::chrono::milliseconds flushInterval = std::chrono::milliseconds(1))
+      : level(level), sampleEvery(std::max(sampleEvery, 1u)), channelSize(channelSize),
+        flushInterval(flushInterval), running(false) {};
+
+  AsyncLogger(const AsyncLogger &) = delete;
+  AsyncLogger &operator=(const AsyncLogger &) = delete;
+
+  /// Stops the flusher, writing out anything still buffered
+  ~AsyncLogger() {
+    stop();
+  }
+
+  /// Changes the lowest level kept. Safe while workers are logging.
+  void set_level(LogLevel newLevel) {
+    level.store(newLevel, std::memory_order_relaxed);
+  }
+
+  /// Changes the sampling rate. Safe while workers are logging.
+  ///
+  /// \param every keep one in this many records below LOG_WARN
+  void set_sampling(unsigned int every) {
+    sampleEvery.store(std::max(every, 1u), std::memory_order_relaxed);
+  }
+
+  /// Creates a channel for a new worker. The channel lives as long as the logger.
+  Channel &channel() {
+    std::lock_guard<std::mutex> lock(channelsMutex);
+    channels.emplace_back(new Channel(*this, channelSize));
+    return *channels.back();
+  }
+
+  /// Starts the flusher thread
+  void start() {
+    if (running.exchange(true)) return;
+    flusher = std::thread(&AsyncLogger::flush_loop, this);
+  }
+
+  /// Stops the flusher thread after a final flush
+  void stop() {
+    if (!running.exchange(false)) return;
+    flusher.join();
+  }
+};
+
+#endif //CSCI411_ASYNCLOGGER_H
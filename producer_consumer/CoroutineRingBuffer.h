@@ -0,0 +1,375 @@
+//
+// Created by Peter on 10/17/2026.
+//
+
+#ifndef CSCI411_COROUTINERINGBUFFER_H
+#define CSCI411_COROUTINERINGBUFFER_H
+
+// Needs C++20; the rest of the ring buffer headers stay C++11
+#if __cplusplus < 202002L
+#error "CoroutineRingBuffer.h needs C++20 coroutines"
+#endif
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "RingBuffer.h"
+#include "MpmcRingBuffer.h"
+#include "UnboundedRingBuffer.h"
+
+// Coroutines that co_await an AsyncRingBuffer park themselves instead of
+// blocking a thread, and are resumed on a CoExecutor, a small pool of
+// threads, once a slot or an item is free. Tens of thousands of parked
+// producers then cost a few hundred bytes of coroutine frame each rather
+// than a thread each.
+//
+//   CoExecutor executor(2);
+//   AsyncRingBuffer<int, Mpmc> ring(1024);
+//   executor.spawn([&]() -> CoTask { co_await ring.enqueue(42); }());
+//   int item = ring.dequeue_sync();  // Threads may use the blocking API
+//   executor.wait_idle();
+
+/// Something a CoExecutor runs: resuming a task, or retrying a parked operation
+class CoJob {
+ public:
+  virtual void run() = 0;
+
+ protected:
+  ~CoJob() = default;
+};
+
+class CoExecutor;
+
+/// A parked coroutine operation, and the executor it goes back to
+struct CoWaiter : CoJob {
+  CoExecutor *executor = nullptr;
+};
+
+/// A fire-and-forget coroutine, started by CoExecutor::spawn().
+/// An exception escaping the coroutine terminates the program.
+class CoTask {
+ public:
+  struct promise_type : CoJob {
+    CoExecutor *executor = nullptr;
+
+    ~promise_type();
+
+    CoTask get_return_object() {
+      return CoTask(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+
+    // Tasks start when spawned and free their frame when they finish
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    std::suspend_never final_suspend() noexcept { return {}; }
+
+    void return_void() {}
+
+    void unhandled_exception() { std::terminate(); }
+
+    void run() override {
+      std::coroutine_handle<promise_type>::from_promise(*this).resume();
+    }
+  };
+
+ private:
+  std::coroutine_handle<promise_type> handle;
+
+  explicit CoTask(std::coroutine_handle<promise_type> handle) : handle(handle) {};
+
+  friend class CoExecutor;
+
+ public:
+  CoTask(CoTask &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {};
+
+  CoTask(const CoTask &) = delete;
+  CoTask &operator=(const CoTask &) = delete;
+
+  /// Destroys a task that was never spawned
+  ~CoTask() {
+    if (handle) handle.destroy();
+  }
+};
+
+/// A small pool of threads that runs coroutines and resumes parked ones
+class CoExecutor {
+ private:
+  RingBuffer<CoJob *, Unbounded, BlockingWait> jobs;
+  std::vector<std::thread> threads;
+
+  std::atomic<size_t> live;  // Spawned tasks that have not finished
+  std::mutex idleMutex;
+  std::condition_variable idle;
+
+  static CoExecutor *&current_executor() {
+    static thread_local CoExecutor *current = nullptr;
+    return current;
+  }
+
+  /// Runs jobs until stop() sends a null one
+  void work() {
+    current_executor() = this;
+    while (CoJob *job = jobs.dequeue_sync()) job->run();
+    current_executor() = nullptr;
+  }
+
+ public:
+  /// Starts the threads
+  ///
+  /// \param numThreads the number of threads, at least one
+  explicit CoExecutor(size_t numThreads) : jobs(1024), live(0) {
+    if (numThreads == 0) throw std::invalid_argument("An executor needs at least one thread");
+    for (size_t i = 0; i < numThreads; ++i) threads.emplace_back(&CoExecutor::work, this);
+  };
+
+  CoExecutor(const CoExecutor &) = delete;
+  CoExecutor &operator=(const CoExecutor &) = delete;
+
+  ~CoExecutor() {
+    stop();
+  }
+
+  /// Returns the executor running the calling thread, or nullptr
+  static CoExecutor *current() {
+    return current_executor();
+  }
+
+  /// Queues a job to run on one of the threads
+  void schedule(CoJob *job) {
+    jobs.enqueue_sync(job);
+  }
+
+  /// Starts a task on the executor. The executor owns it from now on.
+  void spawn(CoTask &&task) {
+    CoTask::promise_type &promise = task.handle.promise();
+    promise.executor = this;
+    live++;
+    task.handle = nullptr;
+    schedule(&promise);
+  }
+
+  /// Called as a spawned task finishes
+  void finished() {
+    if (live.fetch_sub(1) == 1) {
+      std::lock_guard<std::mutex> lock(idleMutex);
+      idle.notify_all();
+    }
+  }
+
+  /// Waits until every spawned task has finished
+  void wait_idle() {
+    std::unique_lock<std::mutex> lock(idleMutex);
+    idle.wait(lock, [this]() { return live.load() == 0; });
+  }
+
+  /// Returns the number of spawned tasks that have not finished
+  size_t tasks() const {
+    return live.load();
+  }
+
+  /// Stops the threads once the jobs queued so far have run. Tasks still
+  /// parked on a ring are never resumed, and their frames are leaked.
+  void stop() {
+    for (size_t i = 0; i < threads.size(); ++i) schedule(nullptr);
+    for (std::thread &thread : threads) {
+      if (thread.joinable()) thread.join();
+    }
+    threads.clear();
+  }
+};
+
+inline CoTask::promise_type::~promise_type() {
+  if (executor) executor->finished();
+}
+
+/// Wait strategy for rings used by both threads and coroutines.
+/// Threads block exactly as with BlockingWait. Coroutines park on a list,
+/// and each notify() hands one of them back to its executor to retry; one
+/// that then succeeds passes the wakeup on, so a bulk operation that frees
+/// many slots still wakes every coroutine it can serve.
+class CoroutineWait {
+ private:
+  BlockingWait threads;
+
+  std::mutex parkMutex;
+  std::deque<CoWaiter *> parked;  // Guarded by parkMutex
+  std::atomic<size_t> parkedCount;
+
+ public:
+  CoroutineWait() : parkedCount(0) {};
+
+  template<typename Ready>
+  void wait(Ready ready) {
+    threads.wait(ready);
+  }
+
+  template<typename Ready>
+  bool wait_until(Ready ready, WaitClock::time_point deadline) {
+    return threads.wait_until(ready, deadline);
+  }
+
+  void notify() {
+    threads.notify();
+    wake_one();
+  }
+
+  /// Hands one parked coroutine back to its executor, if there is one
+  void wake_one() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (parkedCount.load(std::memory_order_relaxed) == 0) return;
+
+    CoWaiter *waiter;
+    {
+      std::lock_guard<std::mutex> lock(parkMutex);
+      if (parked.empty()) return;
+      waiter = parked.front();
+      parked.pop_front();
+      parkedCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+    waiter->executor->schedule(waiter);
+  }
+
+  /// Tries ready() once more, and parks the waiter if it fails. ready()
+  /// runs under the park lock, so it must not notify this wait itself.
+  ///
+  /// \return true if ready() succeeded and the waiter was not parked
+  template<typename Ready>
+  bool park(CoWaiter *waiter, Ready ready) {
+    std::lock_guard<std::mutex> lock(parkMutex);
+    parkedCount.fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (ready()) {
+      parkedCount.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+    parked.push_back(waiter);
+    return false;
+  }
+};
+
+/// RingBuffer with co_await-able enqueue and dequeue on top of the usual
+/// blocking and non-blocking API; threads and coroutines can share one ring
+/// either way round. Coroutines awaiting it must run on a CoExecutor.
+///
+/// \tparam T the item type
+/// \tparam Policy Locking, Mpmc or Unbounded; coroutines resume on any
+///                executor thread, so Spsc is not safe
+/// \tparam Stats whether the RingBuffer keeps counters (NoStats or QueueStats)
+template<typename T, typename Policy = Mpmc, typename Stats = NoStats>
+class AsyncRingBuffer : public RingBuffer<T, Policy, CoroutineWait, Stats> {
+  static_assert(!std::is_same<Policy, Spsc>::value, "Coroutines resume on any thread, so Spsc is not safe");
+
+ private:
+  typedef RingBuffer<T, Policy, CoroutineWait, Stats> Base;
+
+  /// Returns the executor to resume a coroutine on
+  static CoExecutor *resume_on() {
+    CoExecutor *executor = CoExecutor::current();
+    if (!executor) throw std::logic_error("AsyncRingBuffer awaited outside a CoExecutor");
+    return executor;
+  }
+
+ public:
+  /// Awaitable insert; resumes once the item is in the ring
+  class EnqueueAwaiter : public CoWaiter {
+   private:
+    AsyncRingBuffer &ring;
+    T item;
+    std::coroutine_handle<> handle;
+
+    /// Parks, or inserts if there is room now
+    bool insert_or_park() {
+      if (!ring.notFull.park(this, [this]() { return ring.core.emplace(std::move(item)); })) return false;
+      ring.counters.enqueued(1, ring.core);
+      ring.notEmpty.notify();
+      ring.notFull.wake_one();
+      return true;
+    }
+
+   public:
+    EnqueueAwaiter(AsyncRingBuffer &ring, T &&item) : ring(ring), item(std::move(item)) {};
+
+    bool await_ready() {
+      return ring.try_enqueue(std::move(item));
+    }
+
+    bool await_suspend(std::coroutine_handle<> awaiting) {
+      handle = awaiting;
+      executor = resume_on();
+      return !insert_or_park();
+    }
+
+    void await_resume() {}
+
+    /// Retries on the executor after a consumer freed a slot
+    void run() override {
+      if (insert_or_park()) handle.resume();
+    }
+  };
+
+  /// Awaitable remove; resumes with the earliest item
+  class DequeueAwaiter : public CoWaiter {
+   private:
+    AsyncRingBuffer &ring;
+    T item;
+    std::coroutine_handle<> handle;
+
+    /// Parks, or removes if there is an item now
+    bool remove_or_park() {
+      if (!ring.notEmpty.park(this, [this]() { return ring.core.pop(item); })) return false;
+      ring.counters.dequeued(1);
+      ring.notFull.notify();
+      ring.notEmpty.wake_one();
+      return true;
+    }
+
+   public:
+    explicit DequeueAwaiter(AsyncRingBuffer &ring) : ring(ring) {};
+
+    bool await_ready() {
+      return ring.try_dequeue(item);
+    }
+
+    bool await_suspend(std::coroutine_handle<> awaiting) {
+      handle = awaiting;
+      executor = resume_on();
+      return !remove_or_park();
+    }
+
+    T await_resume() {
+      return std::move(item);
+    }
+
+    /// Retries on the executor after a producer inserted an item
+    void run() override {
+      if (remove_or_park()) handle.resume();
+    }
+  };
+
+  /// Creates a new AsyncRingBuffer with the specified size
+  explicit AsyncRingBuffer(unsigned int bufferSize) : Base(bufferSize) {};
+
+  /// co_await inserts a copy of an item, parking the coroutine while the ring is full
+  EnqueueAwaiter enqueue(const T &item) {
+    return EnqueueAwaiter(*this, T(item));
+  }
+
+  /// co_await moves an item in, parking the coroutine while the ring is full
+  EnqueueAwaiter enqueue(T &&item) {
+    return EnqueueAwaiter(*this, std::move(item));
+  }
+
+  /// co_await removes the earliest item, parking the coroutine while the ring is empty
+  DequeueAwaiter dequeue() {
+    return DequeueAwaiter(*this);
+  }
+};
+
+#endif //CSCI411_COROUTINERINGBUFFER_H
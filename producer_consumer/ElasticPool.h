@@ -0,0 +1,270 @@
+//
+// Created by Peter on 10/17/2026.
+//
+
+#ifndef CSCI411_ELASTICPOOL_H
+#define CSCI411_ELASTICPOOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "WaitStrategy.h"
+
+/// When an ElasticPool adds and retires workers.
+/// A pool grows while the queue is under pressure, meaning it is at least
+/// growAt full or items wait longer than latencyTarget, and shrinks while
+/// the queue stays at most shrinkAt full. Both need several samples in a
+/// row, and shrinking needs far more than growing, so a short lull in a
+/// burst does not throw away threads that are needed a moment later.
+struct ElasticPolicy {
+  size_t minWorkers = 1, maxWorkers = 1;
+  double growAt = 0.5;                                  // Fraction of capacity
+  double shrinkAt = 0.05;
+  std::chrono::microseconds latencyTarget{0};           // 0 to only watch occupancy
+  std::chrono::milliseconds interval{5};                // Time between samples
+  unsigned int growAfter = 2, shrinkAfter = 40;         // Samples in a row
+
+  /// A policy that always runs exactly count workers
+  static ElasticPolicy fixed(size_t count) {
+    ElasticPolicy policy;
+    policy.minWorkers = policy.maxWorkers = count;
+    return policy;
+  }
+
+  /// A policy that scales between minWorkers and maxWorkers
+  static ElasticPolicy between(size_t minWorkers, size_t maxWorkers) {
+    ElasticPolicy policy;
+    policy.minWorkers = minWorkers;
+    policy.maxWorkers = std::max(minWorkers, maxWorkers);
+    return policy;
+  }
+};
+
+/// Runs between a minimum and maximum number of copies of a worker loop,
+/// resized by a controller thread that samples queue depth and throughput.
+///
+/// Worker i runs body(i, active) and must return soon after active turns
+/// false; the pool calls wake() right after, for bodies that sleep. Workers
+/// 0..size()-1 are active; the pool always grows and retires at the top,
+/// so ids stay dense. An id is only reused once the thread that last had
+/// it has finished, so no two threads ever run body with the same id;
+/// until then growing waits for a later sample rather than blocking the
+/// controller, and stop() joins the rest without holding the control lock.
+class ElasticPool {
+ public:
+  typedef std::function<void(size_t, const std::atomic<bool> &)> Body;
+
+ private:
+  struct Worker {
+    std::thread thread;
+    std::atomic<bool> active;
+    std::atomic<bool> finished;  // Set once body returned, so joining cannot block
+
+    Worker() : active(false), finished(false) {};
+  };
+
+  const ElasticPolicy policy;
+  const Body body;
+  const std::function<size_t()> depth;       // Items waiting in the queue
+  const size_t capacity;
+  const std::function<uint64_t()> completed; // Items the workers have finished
+  const std::function<void()> wake;          // Wakes sleeping workers to check active
+
+  std::vector<std::unique_ptr<Worker>> workers;
+  std::atomic<size_t> activeCount;
+  std::atomic<size_t> peakCount;
+  std::atomic<uint64_t> resizeCount;
+
+  std::thread controller;
+  bool running = false;  // Guarded by controlMutex
+  mutable std::mutex controlMutex;
+  std::condition_variable controlSignal;
+
+  // Time-weighted worker count, for working out how much the pool cost
+  WaitClock::time_point startTime, lastChange;
+  double workerSeconds = 0;  // Guarded by controlMutex
+
+  /// Adds up worker time since the last change in size
+  void account(WaitClock::time_point now) {
+    workerSeconds += std::chrono::duration<double>(now - lastChange).count() * activeCount.load();
+    lastChange = now;
+  }
+
+  /// Starts worker i, joining the thread that last had id i first
+  ///
+  /// \return false if that thread is still finishing, so nothing started
+  bool spawn(size_t i) {
+    Worker &worker = *workers[i];
+    if (worker.thread.joinable()) {
+      if (!worker.finished) return false;
+      worker.thread.join();
+    }
+    worker.finished = false;
+    worker.active = true;
+    worker.thread = std::thread([this, i, &worker]() {
+      body(i, worker.active);
+      worker.finished = true;
+    });
+    return true;
+  }
+
+  void grow() {
+    size_t n = activeCount.load();
+    if (n >= policy.maxWorkers || !spawn(n)) return;
+    activeCount = n + 1;
+    peakCount = std::max(peakCount.load(), n + 1);
+    resizeCount++;
+  }
+
+  /// Tells the top worker to finish; it is joined when its id is reused, or by stop()
+  void shrink() {
+    size_t n = activeCount.load();
+    if (n <= policy.minWorkers) return;
+    workers[n - 1]->active = false;
+    if (wake) wake();
+    activeCount = n - 1;
+    resizeCount++;
+  }
+
+  /// Samples the queue every interval and resizes the pool
+  void control() {
+    unsigned int hot = 0, cold = 0;
+    uint64_t lastCompleted = completed();
+    WaitClock::time_point lastSample = WaitClock::now();
+
+    std::unique_lock<std::mutex> lock(controlMutex);
+    while (!controlSignal.wait_for(lock, policy.interval, [this]() { return !running; })) {
+      WaitClock::time_point now = WaitClock::now();
+      size_t waiting = depth();
+      uint64_t done = completed();
+
+      double seconds = std::chrono::duration<double>(now - lastSample).count();
+      double rate = seconds > 0 ? (done - lastCompleted) / seconds : 0;
+      double fill = capacity ? static_cast<double>(waiting) / capacity : 0;
+      lastCompleted = done;
+      lastSample = now;
+
+      // Little's law: items waiting over the rate they leave at
+      bool slow = false;
+      if (policy.latencyTarget.count() > 0 && waiting > 0) {
+        slow = rate <= 0 || waiting / rate > std::chrono::duration<double>(policy.latencyTarget).count();
+      }
+
+      if (fill >= policy.growAt || slow) {
+        cold = 0;
+        if (++hot >= policy.growAfter) {
+          account(now);
+          grow();
+          hot = 0;
+        }
+      } else if (fill <= policy.shrinkAt) {
+        hot = 0;
+        if (++cold >= policy.shrinkAfter) {
+          account(now);
+          shrink();
+          cold = 0;
+        }
+      } else {
+        hot = cold = 0;
+      }
+    }
+  }
+
+ public:
+  /// Creates a stopped pool
+  ///
+  /// \param policy the limits and thresholds
+  /// \param body the worker loop
+  /// \param depth returns the number of items waiting
+  /// \param capacity the most items that can wait
+  /// \param completed returns the number of items finished so far
+  /// \param wake wakes workers sleeping outside the queue, if they do
+  ElasticPool(const ElasticPolicy &policy, const Body &body, const std::function<size_t()> &depth,
+              size_t capacity, const std::function<uint64_t()> &completed,
+              const std::function<void()> &wake = std::function<void()>())
+      : policy(policy), body(body), depth(depth), capacity(capacity), completed(completed), wake(wake),
+        activeCount(0), peakCount(0), resizeCount(0) {
+    for (size_t i = 0; i < policy.maxWorkers; ++i) workers.emplace_back(new Worker());
+  };
+
+  ElasticPool(const ElasticPool &) = delete;
+  ElasticPool &operator=(const ElasticPool &) = delete;
+
+  ~ElasticPool() {
+    stop();
+  }
+
+  /// Starts the minimum number of workers and, if the pool can change size,
+  /// the controller
+  void start() {
+    std::lock_guard<std::mutex> lock(controlMutex);
+    if (running) return;
+    running = true;
+
+    startTime = lastChange = WaitClock::now();
+    workerSeconds = 0;
+    for (size_t i = 0; i < policy.minWorkers; ++i) spawn(i);
+    activeCount = peakCount = policy.minWorkers;
+
+    if (policy.maxWorkers > policy.minWorkers) controller = std::thread(&ElasticPool::control, this);
+  }
+
+  /// Stops the controller and every worker, waiting for them to finish
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(controlMutex);
+      if (!running) return;
+      running = false;
+    }
+    controlSignal.notify_all();
+    if (controller.joinable()) controller.join();
+
+    std::vector<std::unique_ptr<Worker>> finishing;
+    {
+      std::lock_guard<std::mutex> lock(controlMutex);
+      account(WaitClock::now());
+      for (std::unique_ptr<Worker> &worker : workers) {
+        worker->active = false;
+        if (worker->thread.joinable()) {
+          finishing.push_back(std::move(worker));
+          worker.reset(new Worker());
+        }
+      }
+      activeCount = 0;
+    }
+    if (wake) wake();
+    for (std::unique_ptr<Worker> &worker : finishing) worker->thread.join();
+  }
+
+  /// Returns the number of active workers
+  size_t size() const {
+    return activeCount.load();
+  }
+
+  /// Returns the most workers that were active at once
+  size_t peak() const {
+    return peakCount.load();
+  }
+
+  /// Returns the number of times the pool grew or shrank
+  uint64_t resizes() const {
+    return resizeCount.load();
+  }
+
+  /// Returns the average number of active workers over the last run,
+  /// once the pool has stopped
+  double average_size() const {
+    std::lock_guard<std::mutex> lock(controlMutex);
+    double seconds = std::chrono::duration<double>(lastChange - startTime).count();
+    return seconds > 0 ? workerSeconds / seconds : static_cast<double>(activeCount.load());
+  }
+};
+
+#endif //CSCI411_ELASTICPOOL_H
@@ -0,0 +1,84 @@
+//
+// Created by Peter on 10/17/2026.
+//
+
+#ifndef CSCI411_LATENCYHISTOGRAM_H
+#define CSCI411_LATENCYHISTOGRAM_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/// Log-linear histogram of non-negative values (HDR histogram style).
+/// Values below 64 are counted exactly; above that every power of two is
+/// split into 64 buckets, so any recorded value is within ~1.6% of its
+/// bucket. Recording is a couple of shifts and an increment.
+class LatencyHistogram {
+ private:
+  static const unsigned int SUB_BITS = 6;
+  static const uint64_t SUB_COUNT = 1ULL << SUB_BITS;
+  static const size_t NUM_BUCKETS = (64 - SUB_BITS + 1) * SUB_COUNT;
+
+  std::vector<uint64_t> counts;
+  uint64_t total = 0, max_value = 0;
+
+  /// Finds the bucket a value falls in
+  static size_t index(uint64_t value) {
+    if (value < SUB_COUNT) return static_cast<size_t>(value);
+    unsigned int shift = (63 - __builtin_clzll(value)) - SUB_BITS;
+    return static_cast<size_t>((shift + 1) * SUB_COUNT + ((value >> shift) - SUB_COUNT));
+  }
+
+  /// Returns the largest value that falls in a bucket
+  static uint64_t highest_in(size_t idx) {
+    if (idx < SUB_COUNT) return idx;
+    unsigned int shift = static_cast<unsigned int>(idx / SUB_COUNT - 1);
+    uint64_t sub = idx % SUB_COUNT;
+    return ((sub + SUB_COUNT + 1) << shift) - 1;
+  }
+
+ public:
+  LatencyHistogram() : counts(NUM_BUCKETS, 0) {};
+
+  /// Records one value
+  void record(uint64_t value) {
+    ++counts[index(value)];
+    ++total;
+    if (value > max_value) max_value = value;
+  }
+
+  /// Adds every value recorded in another histogram
+  void merge(const LatencyHistogram &other) {
+    for (size_t i = 0; i < NUM_BUCKETS; ++i) counts[i] += other.counts[i];
+    total += other.total;
+    if (other.max_value > max_value) max_value = other.max_value;
+  }
+
+  /// Forgets every recorded value
+  void reset() {
+    std::fill(counts.begin(), counts.end(), 0);
+    total = max_value = 0;
+  }
+
+  /// Returns the value below which the given percentage of values fall
+  ///
+  /// \param percentile between 0 and 100
+  uint64_t percentile(double percentile) const {
+    if (total == 0) return 0;
+    uint64_t target = static_cast<uint64_t>(percentile / 100.0 * total + 0.5);
+    if (target < 1) target = 1;
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+      seen += counts[i];
+      if (seen >= target) return std::min(highest_in(i), max_value);
+    }
+    return max_value;
+  }
+
+  uint64_t count() const { return total; }
+
+  uint64_t max() const { return max_value; }
+};
+
+#endif //CSCI411_LATENCYHISTOGRAM_H
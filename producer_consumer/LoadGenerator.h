@@ -0,0 +1,291 @@
+//
+// Created by Peter on 10/17/2026.
+//
+
+#ifndef CSCI411_LOADGENERATOR_H
+#define CSCI411_LOADGENERATOR_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include "WaitStrategy.h"
+
+/// Mixes a 64-bit value (SplitMix64); used to seed generators
+inline uint64_t splitmix64(uint64_t &state) {
+  uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+inline uint64_t rotl64(uint64_t x, int k) {
+  return (x << k) | (x >> (64 - k));
+}
+
+/// xoshiro256** pseudo-random generator: 32 bytes of state, a handful of
+/// shifts and adds per number, and equal seeds give equal sequences
+class Xoshiro256 {
+ private:
+  uint64_t s[4];
+
+ public:
+  /// Seeds one of many independent streams from a single seed
+  ///
+  /// \param seed the run's seed
+  /// \param stream which stream, e.g. a producer id
+  explicit Xoshiro256(uint64_t seed, uint64_t stream = 0) {
+    uint64_t state = seed ^ rotl64(stream * 0xd1b54a32d192ed03ULL, 32);
+    for (uint64_t &word : s) word = splitmix64(state);
+  }
+
+  uint64_t next() {
+    uint64_t result = rotl64(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl64(s[3], 45);
+    return result;
+  }
+
+  /// Returns a double in [0, 1) from the top 53 bits
+  double next_double() {
+    return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0);
+  }
+};
+
+/// Fills arrays with random numbers from LANES interleaved xoshiro256**
+/// streams. Each step updates every lane with the same shifts and adds
+/// on a struct-of-arrays state, so the compiler turns the loop into SIMD
+/// instructions. No intrinsics, so it builds anywhere.
+class BatchRng {
+ public:
+  static const size_t LANES = 8;
+
+ private:
+  alignas(CACHE_LINE_SIZE) uint64_t s0[LANES], s1[LANES], s2[LANES], s3[LANES];
+  uint64_t spare[LANES];  // A step's numbers not yet handed out
+  size_t spareLeft = 0;
+
+  /// Advances every lane once, writing one number per lane
+  void step(uint64_t *out) {
+    for (size_t i = 0; i < LANES; ++i) {
+      uint64_t x = s1[i] * 5;
+      out[i] = ((x << 7) | (x >> 57)) * 9;
+      uint64_t t = s1[i] << 17;
+      s2[i] ^= s0[i];
+      s3[i] ^= s1[i];
+      s1[i] ^= s2[i];
+      s0[i] ^= s3[i];
+      s2[i] ^= t;
+      s3[i] = (s3[i] << 45) | (s3[i] >> 19);
+    }
+  }
+
+ public:
+  /// \param seed the run's seed
+  /// \param stream which stream, e.g. a producer id
+  explicit BatchRng(uint64_t seed, uint64_t stream = 0) {
+    uint64_t state = seed ^ rotl64(stream * 0xd1b54a32d192ed03ULL, 32);
+    for (size_t i = 0; i < LANES; ++i) {
+      s0[i] = splitmix64(state);
+      s1[i] = splitmix64(state);
+      s2[i] = splitmix64(state);
+      s3[i] = splitmix64(state);
+    }
+  }
+
+  /// Writes n random numbers to out
+  void fill(uint64_t *out, size_t n) {
+    while (n > 0 && spareLeft > 0) {
+      *out++ = spare[LANES - spareLeft--];
+      n--;
+    }
+    for (; n >= LANES; n -= LANES, out += LANES) step(out);
+    if (n > 0) {
+      step(spare);
+      memcpy(out, spare, n * sizeof(uint64_t));
+      spareLeft = LANES - n;
+    }
+  }
+};
+
+/// Makes random items of an integral type, uniform over its whole range,
+/// a batch at a time
+template<typename T>
+class ItemGenerator {
+  static_assert(std::is_integral<T>::value, "ItemGenerator makes integral items");
+
+ private:
+  static const size_t BATCH = 64;
+
+  BatchRng rng;
+  uint64_t raw[BATCH];
+  size_t next = BATCH;
+
+ public:
+  explicit ItemGenerator(uint64_t seed, uint64_t stream = 0) : rng(seed, stream) {};
+
+  /// Writes n items to out. The low bits of a uniform 64-bit number are
+  /// uniform, so truncating needs no rejection step.
+  void fill(T *out, size_t n) {
+    while (n > 0) {
+      size_t count = n < BATCH ? n : BATCH;
+      rng.fill(raw, count);
+      for (size_t i = 0; i < count; ++i) out[i] = static_cast<T>(raw[i]);
+      out += count;
+      n -= count;
+    }
+  }
+
+  /// Returns one item, drawn from a buffered batch
+  T operator()() {
+    if (next == BATCH) {
+      rng.fill(raw, BATCH);
+      next = 0;
+    }
+    return static_cast<T>(raw[next++]);
+  }
+};
+
+/// When a producer creates items, or a consumer takes them.
+///
+/// CONSTANT spaces arrivals exactly 1/rate apart. POISSON draws
+/// exponential gaps with mean 1/rate. BURSTY runs at rate for onPeriod,
+/// then pauses for offPeriod, and repeats. UNIFORM waits between minGap
+/// and maxGap, picked uniformly, which is what the original assignment did.
+/// Runs with the same non-zero seed see the same gaps and items.
+struct LoadProfile {
+  enum Arrival {
+    CONSTANT,
+    POISSON,
+    BURSTY,
+    UNIFORM
+  };
+
+  Arrival arrival = UNIFORM;
+  double rate = 0;                                   // Items per second per thread
+  std::chrono::nanoseconds onPeriod{0}, offPeriod{0};
+  std::chrono::nanoseconds minGap = std::chrono::milliseconds(250);
+  std::chrono::nanoseconds maxGap = std::chrono::milliseconds(500);
+  uint64_t seed = 0;                                 // 0 to pick one at start
+
+  static LoadProfile constant(double rate, uint64_t seed = 0) {
+    LoadProfile profile;
+    profile.arrival = CONSTANT;
+    profile.rate = rate;
+    profile.seed = seed;
+    return profile;
+  }
+
+  static LoadProfile poisson(double rate, uint64_t seed = 0) {
+    LoadProfile profile = constant(rate, seed);
+    profile.arrival = POISSON;
+    return profile;
+  }
+
+  static LoadProfile bursty(double rate, std::chrono::nanoseconds onPeriod, std::chrono::nanoseconds offPeriod,
+                            uint64_t seed = 0) {
+    LoadProfile profile = constant(rate, seed);
+    profile.arrival = BURSTY;
+    profile.onPeriod = onPeriod;
+    profile.offPeriod = offPeriod;
+    return profile;
+  }
+
+  static LoadProfile uniform(std::chrono::nanoseconds minGap, std::chrono::nanoseconds maxGap, uint64_t seed = 0) {
+    LoadProfile profile;
+    profile.minGap = minGap;
+    profile.maxGap = std::max(minGap, maxGap);
+    profile.seed = seed;
+    return profile;
+  }
+
+  /// Checks that the profile describes an arrival process
+  ///
+  /// \throws std::invalid_argument if it does not
+  void validate() const {
+    if (arrival != UNIFORM && !(rate > 0)) {
+      throw std::invalid_argument("A load profile needs a positive rate");
+    }
+    if (arrival == BURSTY && onPeriod.count() <= 0) {
+      throw std::invalid_argument("A bursty load profile needs an on period");
+    }
+    if (arrival == BURSTY && offPeriod.count() < 0) {
+      throw std::invalid_argument("A bursty load profile needs an off period of at least zero");
+    }
+    if (arrival == UNIFORM && (minGap.count() < 0 || maxGap < minGap)) {
+      throw std::invalid_argument("A uniform load profile needs 0 <= minGap <= maxGap");
+    }
+  }
+};
+
+/// The arrival times of one thread under a LoadProfile. Times are kept in
+/// absolute terms, so time spent enqueueing does not slow the rate down,
+/// and every arrival that is already due can be handled in one batch.
+class ArrivalSchedule {
+ private:
+  const LoadProfile profile;
+  Xoshiro256 rng;
+  WaitClock::time_point start, arrival;
+
+  /// Returns the time from one arrival to the next
+  std::chrono::nanoseconds gap() {
+    double seconds;
+    switch (profile.arrival) {
+      case LoadProfile::POISSON:
+        seconds = -std::log(1.0 - rng.next_double()) / profile.rate;
+        break;
+      case LoadProfile::UNIFORM:
+        return profile.minGap + std::chrono::nanoseconds(static_cast<int64_t>(
+            rng.next_double() * (profile.maxGap - profile.minGap + std::chrono::nanoseconds(1)).count()));
+      default:
+        seconds = 1.0 / profile.rate;
+        break;
+    }
+    return std::chrono::nanoseconds(static_cast<int64_t>(seconds * 1e9));
+  }
+
+  /// Moves an arrival that falls in an off period to the next on period
+  WaitClock::time_point in_burst(WaitClock::time_point time) const {
+    if (profile.arrival != LoadProfile::BURSTY || profile.offPeriod.count() == 0) return time;
+    std::chrono::nanoseconds cycle = profile.onPeriod + profile.offPeriod;
+    std::chrono::nanoseconds into = (time - start) % cycle;
+    return into < profile.onPeriod ? time : time + (cycle - into);
+  }
+
+ public:
+  /// \param profile the arrival process; its seed must already be set
+  /// \param stream which stream of the seed this thread uses
+  /// \throws std::invalid_argument if the profile is invalid
+  ArrivalSchedule(const LoadProfile &profile, uint64_t stream)
+      : profile(profile), rng(profile.seed, stream), start(WaitClock::now()), arrival(start) {
+    profile.validate();
+    arrival = in_burst(start + gap());
+  };
+
+  /// Returns the time of the next arrival
+  WaitClock::time_point next() const {
+    return arrival;
+  }
+
+  /// Takes the arrivals that are due by now, up to max
+  ///
+  /// \return the number taken
+  size_t take_due(WaitClock::time_point now, size_t max) {
+    size_t due = 0;
+    while (due < max && arrival <= now) {
+      arrival = in_burst(arrival + gap());
+      due++;
+    }
+    return due;
+  }
+};
+
+#endif //CSCI411_LOADGENERATOR_H
@@ -0,0 +1,210 @@
+//
+// Created by Peter on 10/17/2026.
+//
+
+#ifndef CSCI411_MPMCRINGBUFFER_H
+#define CSCI411_MPMCRINGBUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <new>
+#include <utility>
+#include "RingBuffer.h"
+
+/// Multi-producer/multi-consumer ring, used by RingBuffer<T, Mpmc>.
+/// Every slot carries a sequence number that tells producers and consumers
+/// whose turn it is, so the data path needs no mutex. Producers only contend
+/// with producers on insertIdx and consumers only with consumers on removeIdx.
+template<typename T, typename Stats>
+class RingCore<T, Mpmc, Stats> {
+ private:
+  struct Slot {
+    std::atomic<size_t> sequence;
+    union {
+      T item;  // Only constructed while the slot holds an item
+    };
+
+    Slot() {};
+    ~Slot() {};
+  };
+
+  const size_t BUFFER_SIZE, MASK;
+  Slot *buffer;
+
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> insertIdx;
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> removeIdx;
+
+ public:
+  /// Creates a ring with room for at least the specified size.
+  /// The size is rounded up to the next power of two.
+  explicit RingCore(unsigned int bufferSize)
+      : BUFFER_SIZE(next_power_of_two(bufferSize)),
+        MASK(BUFFER_SIZE - 1),
+        buffer(new Slot[BUFFER_SIZE]),
+        insertIdx(0),
+        removeIdx(0) {
+    for (size_t i = 0; i < BUFFER_SIZE; ++i) {
+      buffer[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  };
+
+  /// Returns the slot storage, so it can be placed on a NUMA node
+  const void *storage() const { return buffer; }
+
+  size_t storage_size() const { return sizeof(Slot) * BUFFER_SIZE; }
+
+  size_t capacity() const { return BUFFER_SIZE; }
+
+  /// Returns roughly the number of items in the buffer; exact when no thread
+  /// is inserting or removing
+  size_t size() const {
+    size_t removed = removeIdx.load(std::memory_order_relaxed);
+    size_t inserted = insertIdx.load(std::memory_order_relaxed);
+    return std::min(inserted - std::min(inserted, removed), BUFFER_SIZE);
+  }
+
+  /// Lock-free rings have no mutex to contend on
+  uint64_t contentions() const { return 0; }
+
+  ~RingCore() {
+    const size_t end = insertIdx.load(std::memory_order_relaxed);
+    for (size_t idx = removeIdx.load(std::memory_order_relaxed); idx != end; ++idx) {
+      buffer[idx & MASK].item.~T();
+    }
+    delete[] buffer;
+  }
+
+  /// Claims a slot and constructs an item in it if there is room
+  ///
+  /// \return false if the buffer is full, leaving args untouched
+  template<typename... Args>
+  bool emplace(Args &&... args) {
+    Slot *slot;
+    size_t idx = insertIdx.load(std::memory_order_relaxed);
+
+    while (true) {
+      slot = &buffer[idx & MASK];
+      size_t sequence = slot->sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(idx);
+
+      if (diff == 0) {
+        // Slot is free for this lap, try to claim it
+        if (insertIdx.compare_exchange_weak(idx, idx + 1, std::memory_order_relaxed)) break;
+      } else if (diff < 0) {
+        // Slot still holds last lap's item
+        return false;
+      } else {
+        // Another producer claimed it first
+        idx = insertIdx.load(std::memory_order_relaxed);
+      }
+    }
+
+    new(&slot->item) T(std::forward<Args>(args)...);
+    slot->sequence.store(idx + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Claims a slot and moves its item out if there is one
+  ///
+  /// \return false if the buffer is empty
+  bool pop(T &item) {
+    Slot *slot;
+    size_t idx = removeIdx.load(std::memory_order_relaxed);
+
+    while (true) {
+      slot = &buffer[idx & MASK];
+      size_t sequence = slot->sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(idx + 1);
+
+      if (diff == 0) {
+        // Slot has been published, try to claim it
+        if (removeIdx.compare_exchange_weak(idx, idx + 1, std::memory_order_relaxed)) break;
+      } else if (diff < 0) {
+        // Slot has not been filled yet
+        return false;
+      } else {
+        // Another consumer claimed it first
+        idx = removeIdx.load(std::memory_order_relaxed);
+      }
+    }
+
+    item = std::move(slot->item);
+    slot->item.~T();
+    // Hand the slot to the producer one lap ahead
+    slot->sequence.store(idx + BUFFER_SIZE, std::memory_order_release);
+    return true;
+  }
+
+  /// Claims a run of up to count free slots with a single CAS and fills them
+  ///
+  /// \return the number of items inserted, 0 if the buffer is full
+  template<typename ForwardIt>
+  size_t push_bulk(ForwardIt &first, size_t count) {
+    count = std::min(count, BUFFER_SIZE);
+    size_t idx = insertIdx.load(std::memory_order_relaxed);
+    size_t free;
+
+    while (true) {
+      // Count the free slots after idx. A free slot can only be taken by
+      // moving insertIdx past it, so a successful CAS makes them all ours.
+      free = 0;
+      while (free < count
+          && buffer[(idx + free) & MASK].sequence.load(std::memory_order_acquire) == idx + free) {
+        ++free;
+      }
+
+      if (free == 0) {
+        size_t sequence = buffer[idx & MASK].sequence.load(std::memory_order_acquire);
+        if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(idx) < 0) return 0;
+        idx = insertIdx.load(std::memory_order_relaxed);
+      } else if (insertIdx.compare_exchange_weak(idx, idx + free, std::memory_order_relaxed)) {
+        break;
+      }
+    }
+
+    for (size_t i = 0; i < free; ++i, ++first) {
+      Slot &slot = buffer[(idx + i) & MASK];
+      new(&slot.item) T(*first);
+      slot.sequence.store(idx + i + 1, std::memory_order_release);
+    }
+    return free;
+  }
+
+  /// Claims a run of up to max published slots with a single CAS and moves them out
+  ///
+  /// \return the number of items removed, 0 if the buffer is empty
+  template<typename OutputIt>
+  size_t pop_bulk(OutputIt out, size_t max) {
+    max = std::min(max, BUFFER_SIZE);
+    size_t idx = removeIdx.load(std::memory_order_relaxed);
+    size_t ready;
+
+    while (true) {
+      ready = 0;
+      while (ready < max
+          && buffer[(idx + ready) & MASK].sequence.load(std::memory_order_acquire) == idx + ready + 1) {
+        ++ready;
+      }
+
+      if (ready == 0) {
+        size_t sequence = buffer[idx & MASK].sequence.load(std::memory_order_acquire);
+        if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(idx + 1) < 0) return 0;
+        idx = removeIdx.load(std::memory_order_relaxed);
+      } else if (removeIdx.compare_exchange_weak(idx, idx + ready, std::memory_order_relaxed)) {
+        break;
+      }
+    }
+
+    for (size_t i = 0; i < ready; ++i, ++out) {
+      Slot &slot = buffer[(idx + i) & MASK];
+      *out = std::move(slot.item);
+      slot.item.~T();
+      slot.sequence.store(idx + i + BUFFER_SIZE, std::memory_order_release);
+    }
+    return ready;
+  }
+};
+
+#endif //CSCI411_MPMCRINGBUFFER_H
@@ -0,0 +1,262 @@
+//
+// Created by Peter on 10/17/2026.
+//
+
+#ifndef CSCI411_MULTICASTRINGBUFFER_H
+#define CSCI411_MULTICASTRINGBUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "RingBuffer.h"
+
+/// Bounded ring where every consumer group sees every item (Disruptor style).
+/// Items are written once into a preallocated slot and read in place by
+/// every group, so fanning out to N groups makes no copies.
+///
+/// Each group has its own cursor: the sequence number of the next item it
+/// reads. Producers are gated by the slowest group, so a slot is only
+/// reused once every group is past it. A group can also depend on other
+/// groups, which makes it wait until they are past an item before it sees
+/// it; that turns the groups into a dependency graph, e.g.
+///
+///   persist ---+
+///              +--> forward
+///   aggregate -+
+///
+/// Any number of threads may publish. Each group is read by one thread,
+/// which handles items in batches of whatever is available.
+///
+/// \tparam T the item type, default constructible; slots are reused by assignment
+/// \tparam Wait what producers and groups do while the ring is full or empty
+template<typename T, typename Wait = BlockingWait>
+class MulticastRingBuffer {
+ private:
+  struct Slot {
+    std::atomic<uint64_t> published;  // Sequence + 1 of the item in the slot, 0 if none yet
+    T item;
+
+    Slot() : published(0) {};
+  };
+
+  struct Group : CacheAligned {
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> cursor;
+    Wait ready;
+    std::vector<Group *> upstream, downstream;
+
+    Group() : cursor(0) {};
+  };
+
+  const size_t BUFFER_SIZE, MASK;
+  std::unique_ptr<Slot[]> buffer;
+
+  alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> claimIdx;
+  alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> cachedGating;  // Lags the slowest cursor
+
+  std::vector<std::unique_ptr<Group>> groups;
+  std::vector<Group *> roots;  // Groups that depend on no other group
+  Wait notFull;
+
+  /// Returns the cursor of the slowest group
+  uint64_t gating() const {
+    uint64_t slowest = claimIdx.load(std::memory_order_relaxed);
+    for (const std::unique_ptr<Group> &group : groups) {
+      slowest = std::min(slowest, group->cursor.load(std::memory_order_acquire));
+    }
+    return slowest;
+  }
+
+  /// Claims the next sequence if its slot is free
+  ///
+  /// \return false if the ring is full
+  bool claim(uint64_t &sequence) {
+    uint64_t idx = claimIdx.load(std::memory_order_relaxed);
+
+    while (true) {
+      if (static_cast<int64_t>(idx - cachedGating.load(std::memory_order_acquire)) >= static_cast<int64_t>(BUFFER_SIZE)) {
+        uint64_t slowest = gating();
+        cachedGating.store(slowest, std::memory_order_release);
+        if (static_cast<int64_t>(idx - slowest) >= static_cast<int64_t>(BUFFER_SIZE)) return false;
+      }
+      if (claimIdx.compare_exchange_weak(idx, idx + 1, std::memory_order_relaxed)) {
+        sequence = idx;
+        return true;
+      }
+    }
+  }
+
+  /// Writes an item into a claimed slot and wakes the groups that read first
+  template<typename U>
+  void fill(uint64_t sequence, U &&item) {
+    Slot &slot = buffer[sequence & MASK];
+    slot.item = std::forward<U>(item);
+    slot.published.store(sequence + 1, std::memory_order_release);
+    for (Group *group : roots) group->ready.notify();
+  }
+
+  /// Returns the number of items, up to max, a group may read now
+  size_t available(const Group &group, size_t max) const {
+    uint64_t next = group.cursor.load(std::memory_order_relaxed);
+    uint64_t limit = max < UINT64_MAX - next ? next + max : UINT64_MAX;
+    for (const Group *up : group.upstream) {
+      limit = std::min(limit, up->cursor.load(std::memory_order_acquire));
+    }
+
+    uint64_t end = next;
+    while (end < limit && buffer[end & MASK].published.load(std::memory_order_acquire) == end + 1) ++end;
+    return static_cast<size_t>(end - next);
+  }
+
+  /// Hands count items to the handler, then moves the group past them
+  template<typename Handler>
+  void handle(Group &group, size_t count, Handler &handler) {
+    uint64_t next = group.cursor.load(std::memory_order_relaxed);
+    for (uint64_t sequence = next; sequence < next + count; ++sequence) {
+      handler(static_cast<const T &>(buffer[sequence & MASK].item), sequence);
+    }
+
+    group.cursor.store(next + count, std::memory_order_release);
+    for (Group *down : group.downstream) down->ready.notify();
+    notFull.notify();
+  }
+
+  Group &group_at(size_t group) {
+    if (group >= groups.size()) throw std::out_of_range("No such consumer group");
+    return *groups[group];
+  }
+
+ public:
+  /// Creates a ring with room for at least the specified size.
+  /// The size is rounded up to the next power of two.
+  explicit MulticastRingBuffer(unsigned int bufferSize)
+      : BUFFER_SIZE(next_power_of_two(bufferSize)),
+        MASK(BUFFER_SIZE - 1),
+        buffer(new Slot[BUFFER_SIZE]),
+        claimIdx(0),
+        cachedGating(0) {};
+
+  MulticastRingBuffer(const MulticastRingBuffer &) = delete;
+  MulticastRingBuffer &operator=(const MulticastRingBuffer &) = delete;
+
+  /// Adds a consumer group. Every group must be added before the first
+  /// item is published; a ring with no groups gates nothing.
+  ///
+  /// \param dependsOn groups that must be past an item before this one sees it
+  /// \return the new group's id
+  size_t add_group(const std::vector<size_t> &dependsOn = std::vector<size_t>()) {
+    if (claimIdx.load() != 0) throw std::logic_error("Consumer groups must be added before publishing");
+
+    std::unique_ptr<Group> group(new Group());
+    for (size_t id : dependsOn) {
+      Group &up = group_at(id);
+      group->upstream.push_back(&up);
+      up.downstream.push_back(group.get());
+    }
+    if (group->upstream.empty()) roots.push_back(group.get());
+
+    groups.push_back(std::move(group));
+    return groups.size() - 1;
+  }
+
+  /// Publishes a copy of an item to every group.
+  /// Waits until the slowest group frees a slot.
+  void publish(const T &item) {
+    uint64_t sequence = 0;
+    notFull.wait([&]() { return claim(sequence); });
+    fill(sequence, item);
+  }
+
+  /// Moves an item in and publishes it to every group.
+  /// Waits until the slowest group frees a slot.
+  void publish(T &&item) {
+    uint64_t sequence = 0;
+    notFull.wait([&]() { return claim(sequence); });
+    fill(sequence, std::move(item));
+  }
+
+  /// Publishes a copy of an item if there is a free slot, without waiting
+  ///
+  /// \return false if the slowest group has not freed a slot
+  bool try_publish(const T &item) {
+    uint64_t sequence = 0;
+    if (!claim(sequence)) return false;
+    fill(sequence, item);
+    return true;
+  }
+
+  /// Publishes a copy of an item, waiting at most timeout for a free slot
+  ///
+  /// \return false if no slot was freed in time
+  template<typename Rep, typename Period>
+  bool publish_for(const T &item, const std::chrono::duration<Rep, Period> &timeout) {
+    uint64_t sequence = 0;
+    WaitClock::time_point deadline = WaitClock::now() + timeout;
+    if (!notFull.wait_until([&]() { return claim(sequence); }, deadline)) return false;
+    fill(sequence, item);
+    return true;
+  }
+
+  /// Hands a group's next items to a handler, in order.
+  /// Waits until the group has at least one item, then handles as many as
+  /// are available, up to max. Only one thread may consume a given group.
+  ///
+  /// \param group the group id
+  /// \param handler called as handler(const T &item, uint64_t sequence);
+  ///                the item is only valid during the call
+  /// \param max the most items to handle
+  /// \return the number of items handled
+  template<typename Handler>
+  size_t consume(size_t group, Handler handler, size_t max = SIZE_MAX) {
+    Group &reader = group_at(group);
+    size_t count = 0;
+    reader.ready.wait([&]() { return (count = available(reader, max)) > 0; });
+    handle(reader, count, handler);
+    return count;
+  }
+
+  /// Hands a group's available items, up to max, to a handler without waiting
+  ///
+  /// \return the number of items handled, 0 if there were none
+  template<typename Handler>
+  size_t try_consume(size_t group, Handler handler, size_t max = SIZE_MAX) {
+    Group &reader = group_at(group);
+    size_t count = available(reader, max);
+    if (count > 0) handle(reader, count, handler);
+    return count;
+  }
+
+  /// Hands a group's next items to a handler, waiting at most timeout for one
+  ///
+  /// \return the number of items handled, 0 if none arrived
+  template<typename Handler, typename Rep, typename Period>
+  size_t consume_for(size_t group, Handler handler, const std::chrono::duration<Rep, Period> &timeout,
+                     size_t max = SIZE_MAX) {
+    Group &reader = group_at(group);
+    size_t count = 0;
+    WaitClock::time_point deadline = WaitClock::now() + timeout;
+    if (!reader.ready.wait_until([&]() { return (count = available(reader, max)) > 0; }, deadline)) return 0;
+    handle(reader, count, handler);
+    return count;
+  }
+
+  /// Returns the sequence number of the next item a group will read
+  uint64_t cursor(size_t group) {
+    return group_at(group).cursor.load();
+  }
+
+  /// Returns the number of sequences claimed by producers so far
+  uint64_t published() const {
+    return claimIdx.load();
+  }
+
+  /// Returns the number of slots
+  size_t capacity() const {
+    return BUFFER_SIZE;
+  }
+};
+
+#endif //CSCI411_MULTICASTRINGBUFFER_H
@@ -0,0 +1,534 @@
+//
+// Created by Peter on 10/17/2026.
+//
+
+#ifndef CSCI411_PIPELINE_H
+#define CSCI411_PIPELINE_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "RingBuffer.h"
+#include "MpmcRingBuffer.h"
+
+// A pipeline is a chain of typed stages, built left to right:
+//
+//   Pipeline pipeline = Pipeline::source<Line>("read", readLine, 1)
+//       .map<Record>("parse", parse, 4)
+//       .filter("valid", isValid)
+//       .batch("group", 64)
+//       .sink("write", writeBatch, 1);
+//   pipeline.run();
+//
+// A stage given threads gets its own threads and an Mpmc ring in front of
+// it. A stage given no threads is fused onto the stage before it and runs
+// on that stage's threads as a plain function call, which skips a queue
+// hop. Either way each stage keeps its own counters, so stats() shows
+// which stage holds the pipeline back.
+//
+// Every thread calls its own copy of each user function, so they need only
+// be safe to run concurrently with each other's copies.
+
+/// Snapshot of one pipeline stage
+struct StageStats {
+  std::string name;
+  size_t threads = 0;          // 0 if fused onto the stage before it
+  uint64_t in = 0, out = 0;    // Items taken and passed on; a source only passes on
+  size_t backlog = 0;          // Items waiting in the ring in front of the stage
+  size_t capacity = 0;         // Size of that ring, 0 if fused
+  double itemsPerSecond = 0;   // Items passed on over the run so far
+};
+
+/// Counters of one stage, shared by every thread that runs it
+struct StageCounters : CacheAligned {
+  alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> in;
+  std::atomic<uint64_t> out;
+  std::string name;
+  size_t threads;
+  std::function<size_t()> backlog;
+  size_t capacity = 0;
+
+  StageCounters(const std::string &name, size_t threads) : in(0), out(0), name(name), threads(threads) {};
+};
+
+/// One thread's handle on the rest of its chain: takes items from the
+/// stage before and passes them on. Each thread builds its own chain, so
+/// stateful steps like batching need no locking.
+template<typename T>
+class Emitter {
+ public:
+  virtual ~Emitter() {};
+
+  virtual void push(T &&item) = 0;
+
+  /// Called once after the last item, to flush anything held back
+  virtual void finish() = 0;
+};
+
+/// Builds one thread's chain from a point onwards
+template<typename T>
+using ChainFactory = std::function<std::shared_ptr<Emitter<T>>()>;
+
+/// Counts items locally and adds them to the shared counters in batches,
+/// so fused stages do not bounce a cache line on every item
+class LocalCount {
+ private:
+  static const uint64_t FLUSH_EVERY = 64;
+
+  std::atomic<uint64_t> &total;
+  uint64_t pending = 0;
+
+ public:
+  explicit LocalCount(std::atomic<uint64_t> &total) : total(total) {};
+
+  ~LocalCount() {
+    flush();
+  }
+
+  void add() {
+    if (++pending == FLUSH_EVERY) flush();
+  }
+
+  void flush() {
+    if (pending) total.fetch_add(pending, std::memory_order_relaxed);
+    pending = 0;
+  }
+};
+
+/// The ring between two stages. It closes once every upstream thread has
+/// finished, which tells the downstream threads to stop when it is empty.
+template<typename T>
+class PipelineHop : public CacheAligned {
+ private:
+  static constexpr std::chrono::milliseconds POLL{10};
+
+  RingBuffer<T, Mpmc, BlockingWait> ring;
+  std::atomic<size_t> writers;
+
+ public:
+  explicit PipelineHop(unsigned int size) : ring(size), writers(0) {};
+
+  /// Registers an upstream thread; called while the pipeline is built
+  void add_writer() {
+    writers++;
+  }
+
+  void push(T &&item) {
+    ring.enqueue_sync(std::move(item));
+  }
+
+  void writer_done() {
+    writers.fetch_sub(1, std::memory_order_release);
+  }
+
+  /// Takes the next item, waiting for one
+  ///
+  /// \return false once the ring is closed and empty
+  bool next(T &item) {
+    while (true) {
+      if (ring.dequeue_for(item, POLL)) return true;
+      if (writers.load(std::memory_order_acquire) == 0) return ring.try_dequeue(item);
+    }
+  }
+
+  size_t size() {
+    return ring.size();
+  }
+
+  size_t capacity() const {
+    return ring.capacity();
+  }
+};
+
+template<typename T>
+constexpr std::chrono::milliseconds PipelineHop<T>::POLL;
+
+/// Runs f on each item and passes the result on
+template<typename T, typename U, typename F>
+class MapEmitter : public Emitter<T> {
+ private:
+  F f;
+  std::shared_ptr<Emitter<U>> next;
+  LocalCount in, out;
+
+ public:
+  MapEmitter(const F &f, const std::shared_ptr<Emitter<U>> &next, StageCounters &counters)
+      : f(f), next(next), in(counters.in), out(counters.out) {};
+
+  void push(T &&item) override {
+    in.add();
+    U result = f(std::move(item));
+    out.add();
+    next->push(std::move(result));
+  }
+
+  void finish() override {
+    in.flush();
+    out.flush();
+    next->finish();
+  }
+};
+
+/// Passes on the items a predicate accepts
+template<typename T, typename F>
+class FilterEmitter : public Emitter<T> {
+ private:
+  F keep;
+  std::shared_ptr<Emitter<T>> next;
+  LocalCount in, out;
+
+ public:
+  FilterEmitter(const F &keep, const std::shared_ptr<Emitter<T>> &next, StageCounters &counters)
+      : keep(keep), next(next), in(counters.in), out(counters.out) {};
+
+  void push(T &&item) override {
+    in.add();
+    if (!keep(static_cast<const T &>(item))) return;
+    out.add();
+    next->push(std::move(item));
+  }
+
+  void finish() override {
+    in.flush();
+    out.flush();
+    next->finish();
+  }
+};
+
+/// Groups items into vectors of a fixed size; the last one may be short
+template<typename T>
+class BatchEmitter : public Emitter<T> {
+ private:
+  const size_t SIZE;
+  std::vector<T> batch;
+  std::shared_ptr<Emitter<std::vector<T>>> next;
+  LocalCount in, out;
+
+  void emit() {
+    out.add();
+    next->push(std::move(batch));
+    batch = std::vector<T>();
+    batch.reserve(SIZE);
+  }
+
+ public:
+  BatchEmitter(size_t size, const std::shared_ptr<Emitter<std::vector<T>>> &next, StageCounters &counters)
+      : SIZE(size), next(next), in(counters.in), out(counters.out) {
+    batch.reserve(SIZE);
+  };
+
+  void push(T &&item) override {
+    in.add();
+    batch.push_back(std::move(item));
+    if (batch.size() == SIZE) emit();
+  }
+
+  void finish() override {
+    if (!batch.empty()) emit();
+    in.flush();
+    out.flush();
+    next->finish();
+  }
+};
+
+/// Hands each item to the user's sink function
+template<typename T, typename F>
+class SinkEmitter : public Emitter<T> {
+ private:
+  F f;
+  LocalCount in, out;
+
+ public:
+  SinkEmitter(const F &f, StageCounters &counters) : f(f), in(counters.in), out(counters.out) {};
+
+  void push(T &&item) override {
+    in.add();
+    f(std::move(item));
+    out.add();
+  }
+
+  void finish() override {
+    in.flush();
+    out.flush();
+  }
+};
+
+/// Pushes into the ring in front of the next threaded stage
+template<typename T>
+class HopEmitter : public Emitter<T> {
+ private:
+  std::shared_ptr<PipelineHop<T>> hop;
+
+ public:
+  explicit HopEmitter(const std::shared_ptr<PipelineHop<T>> &hop) : hop(hop) {
+    hop->add_writer();
+  };
+
+  void push(T &&item) override {
+    hop->push(std::move(item));
+  }
+
+  void finish() override {
+    hop->writer_done();
+  }
+};
+
+template<typename T>
+class Flow;
+
+/// A built pipeline: its threads, rings and per-stage counters
+class Pipeline {
+ public:
+  /// Everything the stages share, kept alive by every Flow and the Pipeline
+  struct State {
+    std::vector<std::unique_ptr<StageCounters>> stages;
+    std::vector<std::function<void()>> bodies;  // One per thread
+    std::vector<std::thread> threads;
+    unsigned int queueSize = 1024;
+    bool built = false;
+    WaitClock::time_point startTime, endTime;
+    std::atomic<bool> finished;
+
+    State() : finished(false) {};
+
+    StageCounters &add_stage(const std::string &name, size_t threads) {
+      stages.emplace_back(new StageCounters(name, threads));
+      return *stages.back();
+    }
+  };
+
+ private:
+  std::shared_ptr<State> state;
+
+ public:
+  explicit Pipeline(const std::shared_ptr<State> &state) : state(state) {};
+
+  Pipeline(Pipeline &&) = default;
+  Pipeline &operator=(Pipeline &&) = default;
+
+  ~Pipeline() {
+    if (state) wait();
+  }
+
+  /// Starts a pipeline with a source stage
+  ///
+  /// \tparam T the type the source produces
+  /// \param name the stage name in stats()
+  /// \param next called as bool next(T &item); fills item and returns
+  ///             true, or returns false once the source is exhausted
+  /// \param threads the number of source threads
+  template<typename T, typename F>
+  static Flow<T> source(const std::string &name, F next, size_t threads = 1);
+
+  /// Starts every stage's threads
+  void start() {
+    if (!state->threads.empty()) return;
+    state->startTime = WaitClock::now();
+    for (const std::function<void()> &body : state->bodies) state->threads.emplace_back(body);
+  }
+
+  /// Waits until the sources are exhausted and every item has reached the sink
+  void wait() {
+    for (std::thread &thread : state->threads) {
+      if (thread.joinable()) thread.join();
+    }
+    if (!state->threads.empty() && !state->finished) {
+      state->endTime = WaitClock::now();
+      state->finished = true;
+    }
+  }
+
+  /// Starts the pipeline and waits for it to finish
+  void run() {
+    start();
+    wait();
+  }
+
+  /// Returns a snapshot of every stage, in order from the source. Counts
+  /// are batched per thread, so while the pipeline runs they may lag a little.
+  std::vector<StageStats> stats() const {
+    WaitClock::time_point end = state->finished ? state->endTime : WaitClock::now();
+    double seconds = state->threads.empty() ? 0 : std::chrono::duration<double>(end - state->startTime).count();
+
+    std::vector<StageStats> result;
+    for (const std::unique_ptr<StageCounters> &stage : state->stages) {
+      StageStats each;
+      each.name = stage->name;
+      each.threads = stage->threads;
+      each.in = stage->in.load(std::memory_order_relaxed);
+      each.out = stage->out.load(std::memory_order_relaxed);
+      each.backlog = stage->backlog ? stage->backlog() : 0;
+      each.capacity = stage->capacity;
+      each.itemsPerSecond = seconds > 0 ? each.out / seconds : 0;
+      result.push_back(each);
+    }
+    return result;
+  }
+
+  /// Prints stats() as a table, one stage per line
+  void print_stats(std::ostream &out) const {
+    out << std::left << std::setw(12) << "stage" << std::right << std::setw(8) << "threads"
+        << std::setw(12) << "in" << std::setw(12) << "out" << std::setw(14) << "items/s"
+        << std::setw(12) << "backlog" << std::endl;
+    for (const StageStats &stage : stats()) {
+      out << std::left << std::setw(12) << stage.name << std::right << std::setw(8)
+          << (stage.threads ? std::to_string(stage.threads) : "fused")
+          << std::setw(12) << stage.in << std::setw(12) << stage.out
+          << std::setw(14) << std::fixed << std::setprecision(0) << stage.itemsPerSecond
+          << std::setw(12) << (stage.capacity ? std::to_string(stage.backlog) + "/" + std::to_string(stage.capacity) : "-")
+          << std::endl;
+    }
+  }
+};
+
+/// The open end of a pipeline under construction, producing items of type T.
+/// Each call adds a stage and returns the new open end; sink() closes the
+/// pipeline and returns it. A Flow is used up by the call that extends it.
+template<typename T>
+class Flow {
+  template<typename U>
+  friend class Flow;
+  friend class Pipeline;
+
+ private:
+  /// Given the chain that follows, registers the threads that feed it
+  typedef std::function<void(const ChainFactory<T> &)> Attach;
+
+  std::shared_ptr<Pipeline::State> state;
+  Attach attach;
+
+  Flow(const std::shared_ptr<Pipeline::State> &state, const Attach &attach) : state(state), attach(attach) {};
+
+  void check_open() const {
+    if (state->built) throw std::logic_error("The pipeline has already been built");
+  }
+
+  /// Ends the fused segment so far in a ring, and returns an Attach for
+  /// threads threads that read from it and run the chain after them
+  Attach hop(StageCounters &counters, size_t threads) {
+    std::shared_ptr<PipelineHop<T>> ring(new PipelineHop<T>(state->queueSize));
+    counters.backlog = [ring]() { return ring->size(); };
+    counters.capacity = ring->capacity();
+
+    std::shared_ptr<Pipeline::State> shared = state;
+    Attach upstream = attach;
+    return [shared, upstream, ring, threads](const ChainFactory<T> &downstream) {
+      upstream([ring]() { return std::shared_ptr<Emitter<T>>(new HopEmitter<T>(ring)); });
+      for (size_t i = 0; i < threads; ++i) {
+        std::shared_ptr<Emitter<T>> chain = downstream();
+        shared->bodies.push_back([ring, chain]() {
+          T item;
+          while (ring->next(item)) chain->push(std::move(item));
+          chain->finish();
+        });
+      }
+    };
+  }
+
+  /// Adds a stage that wraps the chain after it in a per-thread emitter
+  template<typename U, typename Make>
+  Flow<U> extend(const std::string &name, size_t threads, Make make) {
+    check_open();
+    StageCounters &counters = state->add_stage(name, threads);
+    Attach upstream = threads ? hop(counters, threads) : attach;
+    StageCounters *stage = &counters;
+
+    return Flow<U>(state, [upstream, make, stage](const ChainFactory<U> &downstream) {
+      upstream([make, stage, downstream]() { return make(downstream(), *stage); });
+    });
+  }
+
+ public:
+  Flow(Flow &&) = default;
+  Flow &operator=(Flow &&) = default;
+
+  /// Sets the size of the rings in front of the stages added after this
+  Flow queue_size(unsigned int size) {
+    state->queueSize = size;
+    return std::move(*this);
+  }
+
+  /// Adds a stage that turns each item into a U
+  ///
+  /// \param f called as U f(T &&item)
+  /// \param threads the stage's own threads, or 0 to fuse it onto the stage before
+  template<typename U, typename F>
+  Flow<U> map(const std::string &name, F f, size_t threads = 0) {
+    return extend<U>(name, threads, [f](const std::shared_ptr<Emitter<U>> &next, StageCounters &counters) {
+      return std::shared_ptr<Emitter<T>>(new MapEmitter<T, U, F>(f, next, counters));
+    });
+  }
+
+  /// Adds a stage that drops the items a predicate rejects
+  ///
+  /// \param keep called as bool keep(const T &item)
+  template<typename F>
+  Flow<T> filter(const std::string &name, F keep, size_t threads = 0) {
+    return extend<T>(name, threads, [keep](const std::shared_ptr<Emitter<T>> &next, StageCounters &counters) {
+      return std::shared_ptr<Emitter<T>>(new FilterEmitter<T, F>(keep, next, counters));
+    });
+  }
+
+  /// Adds a stage that groups items into vectors of size items. Each thread
+  /// batches on its own and flushes a short batch when its input ends.
+  Flow<std::vector<T>> batch(const std::string &name, size_t size, size_t threads = 0) {
+    if (size == 0) throw std::invalid_argument("Batch size must be at least 1");
+    return extend<std::vector<T>>(name, threads,
+        [size](const std::shared_ptr<Emitter<std::vector<T>>> &next, StageCounters &counters) {
+          return std::shared_ptr<Emitter<T>>(new BatchEmitter<T>(size, next, counters));
+        });
+  }
+
+  /// Ends the pipeline with a stage that consumes every item
+  ///
+  /// \param f called as f(T &&item)
+  /// \param threads the stage's own threads, or 0 to fuse it onto the stage before
+  /// \return the built pipeline, not yet started
+  template<typename F>
+  Pipeline sink(const std::string &name, F f, size_t threads = 0) {
+    check_open();
+    StageCounters &counters = state->add_stage(name, threads);
+    Attach upstream = threads ? hop(counters, threads) : attach;
+    StageCounters *stage = &counters;
+
+    upstream([f, stage]() { return std::shared_ptr<Emitter<T>>(new SinkEmitter<T, F>(f, *stage)); });
+    state->built = true;
+    return Pipeline(state);
+  }
+};
+
+template<typename T, typename F>
+Flow<T> Pipeline::source(const std::string &name, F next, size_t threads) {
+  if (threads == 0) throw std::invalid_argument("A source needs at least one thread");
+  std::shared_ptr<State> state(new State());
+  StageCounters *stage = &state->add_stage(name, threads);
+
+  return Flow<T>(state, [state, next, threads, stage](const ChainFactory<T> &downstream) {
+    for (size_t i = 0; i < threads; ++i) {
+      std::shared_ptr<Emitter<T>> chain = downstream();
+      F produce = next;
+      state->bodies.push_back([produce, chain, stage]() mutable {
+        LocalCount out(stage->out);
+        T item;
+        while (produce(item)) {
+          out.add();
+          chain->push(std::move(item));
+        }
+        out.flush();
+        chain->finish();
+      });
+    }
+  });
+}
+
+#endif //CSCI411_PIPELINE_H
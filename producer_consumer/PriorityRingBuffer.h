@@ -0,0 +1,304 @@
+//
+// Created by Peter on 10/17/2026.
+//
+
+#ifndef CSCI411_PRIORITYRINGBUFFER_H
+#define CSCI411_PRIORITYRINGBUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "RingBuffer.h"
+#include "MpmcRingBuffer.h"
+
+/// How a PriorityRingBuffer picks the lane to dequeue from.
+/// Lane 0 is the highest priority.
+///
+/// STRICT always drains the highest non-empty lane. WEIGHTED serves lanes
+/// in proportion to their weights, skipping empty ones. Either way, a
+/// non-empty lane passed over for agingLimit dequeues in a row is served
+/// next, so low lanes cannot starve.
+struct LaneSchedule {
+  enum Mode {
+    STRICT,
+    WEIGHTED
+  };
+
+  Mode mode = STRICT;
+  std::vector<unsigned int> weights;  // One per lane, for WEIGHTED
+  uint64_t agingLimit = 1024;         // Dequeues a waiting lane may be passed over, 0 for never
+
+  /// Higher lanes first
+  static LaneSchedule strict(uint64_t agingLimit = 1024) {
+    LaneSchedule schedule;
+    schedule.agingLimit = agingLimit;
+    return schedule;
+  }
+
+  /// Lanes in proportion to weights, e.g. {8, 4, 1}
+  static LaneSchedule weighted(const std::vector<unsigned int> &weights, uint64_t agingLimit = 1024) {
+    LaneSchedule schedule;
+    schedule.mode = WEIGHTED;
+    schedule.weights = weights;
+    schedule.agingLimit = agingLimit;
+    return schedule;
+  }
+};
+
+/// Snapshot of one lane
+struct LaneStats {
+  size_t size = 0, capacity = 0;
+  uint64_t enqueues = 0, dequeues = 0;
+  uint64_t aged = 0;  // Dequeues served early because the lane was starving
+};
+
+/// Ring buffer with several priority lanes, each its own bounded ring.
+/// A bitmask of non-empty lanes lets a dequeue find its lane with one bit
+/// scan rather than by looking at each lane, so it stays O(1) however
+/// many lanes there are. Items are FIFO within a lane.
+///
+/// \tparam T the item type
+/// \tparam Policy the synchronization policy of each lane (Locking or Mpmc)
+/// \tparam Wait what a thread does while its lane is full or every lane is empty
+template<typename T, typename Policy = Mpmc, typename Wait = BlockingWait>
+class PriorityRingBuffer {
+  static_assert(!std::is_same<Policy, Spsc>::value, "Lanes are shared by every producer and consumer");
+
+ public:
+  static const size_t MAX_LANES = 64;
+
+ private:
+  struct Lane : CacheAligned {
+    RingCore<T, Policy> core;
+    Wait notFull;
+    std::atomic<uint64_t> lastServed;  // Ticket of the last dequeue from this lane
+    std::atomic<uint64_t> enqueues, dequeues, aged;
+
+    explicit Lane(unsigned int size) : core(size), lastServed(0), enqueues(0), dequeues(0), aged(0) {};
+  };
+
+  const LaneSchedule schedule;
+  std::vector<std::unique_ptr<Lane>> lanes;
+  std::vector<uint8_t> order;  // WEIGHTED: lane to prefer for each ticket
+
+  alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> nonEmpty;  // Bit i is set while lane i may hold items
+  alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> tickets;   // Dequeue attempts so far
+  Wait notEmpty;
+
+  static uint64_t bit(size_t lane) {
+    return uint64_t(1) << lane;
+  }
+
+  /// Spreads each lane's turns evenly over one round, so a heavy lane does
+  /// not take all its turns in a row (smooth weighted round-robin)
+  static std::vector<uint8_t> interleave(const std::vector<unsigned int> &weights) {
+    std::vector<uint8_t> result;
+    std::vector<long> current(weights.size(), 0);
+    long total = 0;
+    for (unsigned int weight : weights) total += weight;
+
+    for (long turn = 0; turn < total; ++turn) {
+      size_t best = 0;
+      for (size_t i = 0; i < weights.size(); ++i) {
+        current[i] += weights[i];
+        if (current[i] > current[best]) best = i;
+      }
+      current[best] -= total;
+      result.push_back(static_cast<uint8_t>(best));
+    }
+    return result;
+  }
+
+  /// Returns the first lane at or after start, wrapping around, in mask
+  size_t next_lane(uint64_t mask, size_t start) const {
+    uint64_t after = mask & (~uint64_t(0) << start);
+    return static_cast<size_t>(__builtin_ctzll(after ? after : mask));
+  }
+
+  /// Picks the lane the schedule wants for this ticket, among the non-empty ones
+  size_t pick(uint64_t mask, uint64_t ticket) const {
+    if (schedule.mode == LaneSchedule::STRICT) return static_cast<size_t>(__builtin_ctzll(mask));
+    return next_lane(mask, order[ticket % order.size()]);
+  }
+
+  /// Pops from one lane. If it is empty, clears its bit, then tries once
+  /// more in case a producer filled it between the pop and the clear.
+  bool pop_lane(size_t lane, T &item) {
+    Lane &chosen = *lanes[lane];
+    if (!chosen.core.pop(item)) {
+      nonEmpty.fetch_and(~bit(lane));
+      if (!chosen.core.pop(item)) return false;
+      nonEmpty.fetch_or(bit(lane));
+    }
+    return true;
+  }
+
+  /// Removes the next item by the schedule
+  ///
+  /// \param lane set to the lane the item came from
+  /// \return false if every lane is empty
+  bool remove(T &item, size_t &lane) {
+    uint64_t ticket = tickets.fetch_add(1, std::memory_order_relaxed);
+    uint64_t mask = nonEmpty.load();
+    if (mask == 0) return false;
+
+    // Each dequeue checks one lane for starvation, so every lane is
+    // checked once every lanes.size() dequeues
+    size_t check = static_cast<size_t>(ticket % lanes.size());
+    if (schedule.agingLimit && (mask & bit(check))
+        && ticket - lanes[check]->lastServed.load(std::memory_order_relaxed) > schedule.agingLimit
+        && pop_lane(check, item)) {
+      lanes[check]->aged.fetch_add(1, std::memory_order_relaxed);
+      lane = check;
+    } else {
+      while (true) {
+        if (mask == 0) return false;
+        lane = pick(mask, ticket);
+        if (pop_lane(lane, item)) break;
+        mask = nonEmpty.load() & ~bit(lane);
+      }
+    }
+
+    lanes[lane]->lastServed.store(ticket, std::memory_order_relaxed);
+    lanes[lane]->dequeues.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  /// Marks a lane non-empty after an insert and wakes a consumer
+  void inserted(size_t lane) {
+    Lane &into = *lanes[lane];
+    into.enqueues.fetch_add(1, std::memory_order_relaxed);
+
+    // A lane only ages while it has items, so restart its clock when it fills
+    if (!(nonEmpty.fetch_or(bit(lane)) & bit(lane))) {
+      into.lastServed.store(tickets.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    notEmpty.notify();
+  }
+
+  Lane &lane_at(size_t lane) {
+    if (lane >= lanes.size()) throw std::out_of_range("No such priority lane");
+    return *lanes[lane];
+  }
+
+ public:
+  /// Creates the lanes
+  ///
+  /// \param numLanes the number of lanes, 1 to MAX_LANES
+  /// \param laneSize the size of each lane's ring
+  /// \param schedule how dequeues pick a lane
+  PriorityRingBuffer(size_t numLanes, unsigned int laneSize, const LaneSchedule &schedule = LaneSchedule())
+      : schedule(schedule), nonEmpty(0), tickets(0) {
+    if (numLanes == 0 || numLanes > MAX_LANES) throw std::invalid_argument("A PriorityRingBuffer has 1 to 64 lanes");
+    if (schedule.mode == LaneSchedule::WEIGHTED) {
+      if (schedule.weights.size() != numLanes) throw std::invalid_argument("WEIGHTED needs one weight per lane");
+      if (std::find(schedule.weights.begin(), schedule.weights.end(), 0u) != schedule.weights.end()) {
+        throw std::invalid_argument("Lane weights must be at least 1");
+      }
+      order = interleave(schedule.weights);
+    }
+
+    for (size_t i = 0; i < numLanes; ++i) lanes.emplace_back(new Lane(laneSize));
+  };
+
+  PriorityRingBuffer(const PriorityRingBuffer &) = delete;
+  PriorityRingBuffer &operator=(const PriorityRingBuffer &) = delete;
+
+  /// Inserts a copy of an item into a lane.
+  /// Waits until there is room in that lane.
+  void enqueue_sync(const T &item, size_t lane) {
+    Lane &into = lane_at(lane);
+    into.notFull.wait([&]() { return into.core.emplace(item); });
+    inserted(lane);
+  }
+
+  /// Moves an item into a lane.
+  /// Waits until there is room in that lane.
+  void enqueue_sync(T &&item, size_t lane) {
+    Lane &into = lane_at(lane);
+    into.notFull.wait([&]() { return into.core.emplace(std::move(item)); });
+    inserted(lane);
+  }
+
+  /// Inserts a copy of an item into a lane if it has room, without waiting
+  ///
+  /// \return false if the lane is full
+  bool try_enqueue(const T &item, size_t lane) {
+    if (!lane_at(lane).core.emplace(item)) return false;
+    inserted(lane);
+    return true;
+  }
+
+  /// Removes the next item by the schedule.
+  /// Waits until some lane has an item.
+  T dequeue_sync() {
+    T result;
+    size_t lane = 0;
+    notEmpty.wait([&]() { return remove(result, lane); });
+    lanes[lane]->notFull.notify();
+    return result;
+  }
+
+  /// Removes the next item by the schedule if there is one, without waiting
+  ///
+  /// \param lane if not null, set to the lane the item came from
+  /// \return false if every lane is empty
+  bool try_dequeue(T &item, size_t *lane = nullptr) {
+    size_t from = 0;
+    if (!remove(item, from)) return false;
+    lanes[from]->notFull.notify();
+    if (lane) *lane = from;
+    return true;
+  }
+
+  /// Removes the next item by the schedule, waiting at most timeout for one
+  ///
+  /// \return false if every lane stayed empty
+  template<typename Rep, typename Period>
+  bool dequeue_for(T &item, const std::chrono::duration<Rep, Period> &timeout, size_t *lane = nullptr) {
+    size_t from = 0;
+    if (!notEmpty.wait_until([&]() { return remove(item, from); }, WaitClock::now() + timeout)) return false;
+    lanes[from]->notFull.notify();
+    if (lane) *lane = from;
+    return true;
+  }
+
+  /// Returns the number of lanes
+  size_t num_lanes() const {
+    return lanes.size();
+  }
+
+  /// Returns the number of items in a lane; only a hint while other threads
+  /// are inserting or removing
+  size_t size(size_t lane) {
+    return lane_at(lane).core.size();
+  }
+
+  /// Returns the number of items in every lane
+  size_t size() {
+    size_t total = 0;
+    for (std::unique_ptr<Lane> &each : lanes) total += each->core.size();
+    return total;
+  }
+
+  /// Returns a snapshot of every lane's occupancy and counters
+  std::vector<LaneStats> lane_stats() {
+    std::vector<LaneStats> result;
+    for (std::unique_ptr<Lane> &each : lanes) {
+      LaneStats stats;
+      stats.size = each->core.size();
+      stats.capacity = each->core.capacity();
+      stats.enqueues = each->enqueues.load(std::memory_order_relaxed);
+      stats.dequeues = each->dequeues.load(std::memory_order_relaxed);
+      stats.aged = each->aged.load(std::memory_order_relaxed);
+      result.push_back(stats);
+    }
+    return result;
+  }
+};
+
+#endif //CSCI411_PRIORITYRINGBUFFER_H
@@ -6,73 +6,188 @@
 #define CSCI411_PRODUCERCONSUMER_H
 
 #include <iostream>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <thread>
-#include <ctime>
 #include <random>
-#include <sstream>
+#include <vector>
+#include <type_traits>
 #include "RingBuffer.h"
+#include "ShardedRingBuffer.h"
+#include "AsyncLogger.h"
+#include "ThreadPlacement.h"
+#include "ElasticPool.h"
+#include "LoadGenerator.h"
 
-template<typename T>
+/// Runs producer and consumer threads over a shared RingBuffer, or in
+/// sharded mode over a ShardedRingBuffer with one shard per producer
+///
+/// \tparam T the item type
+/// \tparam Policy the RingBuffer synchronization policy (Locking, Spsc or Mpmc)
+/// \tparam Wait the RingBuffer wait strategy
+/// \tparam Stats whether the RingBuffer keeps counters (NoStats or QueueStats)
+template<typename T, typename Policy = Locking, typename Wait = BlockingWait, typename Stats = NoStats>
 class ProducerConsumer {
+ public:
+  /// Stolen shards have several consumers, so Spsc shards become Mpmc
+  typedef typename std::conditional<std::is_same<Policy, Spsc>::value, Mpmc, Policy>::type ShardPolicy;
+  typedef ShardedRingBuffer<T, ShardPolicy, Wait> ShardedBuffer;
+
  private:
-  std::reference_wrapper<RingBuffer<T>> ringBuffer;
+  // Exactly one of these is set
+  RingBuffer<T, Policy, Wait, Stats> *ringBuffer = nullptr;
+  ShardedBuffer *shardedBuffer = nullptr;
   const size_t NUM_PRODUCER_THREADS, NUM_CONSUMER_THREADS;
+  AsyncLogger logger;
+  ThreadPlacement placement;
+
+  // Producers started by start(), and what stop() uses to end them
+  std::vector<std::thread> workers;
+  std::atomic<bool> running;
+  std::mutex stopMutex;
+  std::condition_variable stopSignal;
+
+  // Consumers run in a pool, fixed in size unless set_elastic() was called
+  ElasticPolicy consumerPolicy;
+  std::unique_ptr<ElasticPool> consumers;
+  std::vector<AsyncLogger::Channel *> consumerLogs;
+  std::atomic<uint64_t> consumed;
+
+  // When producers make items and consumers take them, for start()
+  LoadProfile producerLoad, consumerLoad;
+
+  /// Inserts an item into the ring, or into the producer's own shard
+  void enqueue(size_t producer_id, T item) {
+    if (shardedBuffer) shardedBuffer->enqueue_sync(producer_id, std::move(item));
+    else ringBuffer->enqueue_sync(std::move(item));
+  }
 
-  /// Returns a static thread local RNG
-  static thread_local std::mt19937 rng() {
-    return std::mt19937(
-        clock() + std::hash<std::thread::id>()(std::this_thread::get_id())
-    );
+  /// Returns roughly the number of items waiting in the ring or shards
+  size_t depth() {
+    return shardedBuffer ? shardedBuffer->count() : ringBuffer->size();
   }
 
-  /// Sleeps thread for 250-500 ms
-  void sleep_random() {
-    // Random number generation
-    std::mt19937 generator = rng();
-    static thread_local std::uniform_int_distribution<int> sleep_dist(250, 500);
+  /// Returns the most items that can wait in the ring or shards
+  size_t capacity() const {
+    return shardedBuffer ? shardedBuffer->capacity() : ringBuffer->capacity();
+  }
 
-    std::this_thread::sleep_for(std::chrono::milliseconds(sleep_dist(generator)));
+  /// Creates the consumer pool around a consumer loop
+  void make_consumers(const ElasticPool::Body &body) {
+    consumers.reset(new ElasticPool(
+        consumerPolicy, body,
+        [this]() { return depth(); }, capacity(),
+        [this]() { return consumed.load(std::memory_order_relaxed); },
+        [this]() { wake_sleepers(); }
+    ));
   }
 
-  /// Inserts items into RingBuffer
+  /// Inserts an item, waiting at most timeout for room
   ///
-  /// \param producer_id the id of the producer
-  void producer(size_t producer_id) {
-    // Random number generation
-    std::mt19937 generator = rng();
-    std::uniform_int_distribution<T> item_dist(
-        std::numeric_limits<T>::min(),
-        std::numeric_limits<T>::max()
-    );
+  /// \return false if there was no room
+  template<typename Rep, typename Period>
+  bool enqueue_for(size_t producer_id, const T &item, const std::chrono::duration<Rep, Period> &timeout) {
+    if (shardedBuffer) return shardedBuffer->enqueue_for(producer_id, item, timeout);
+    return ringBuffer->enqueue_for(item, timeout);
+  }
 
-    // Buffer item
-    T item;
+  /// Removes an item, waiting at most timeout for one to arrive
+  ///
+  /// \return false if nothing arrived
+  template<typename Rep, typename Period>
+  bool dequeue_for(size_t consumer_id, T &item, const std::chrono::duration<Rep, Period> &timeout) {
+    if (shardedBuffer) return shardedBuffer->dequeue_for(consumer_id, item, timeout);
+    return ringBuffer->dequeue_for(item, timeout);
+  }
 
-    // Output text
+  /// Most arrivals a worker handles per wakeup
+  static const size_t ARRIVAL_BATCH = 64;
 
+  /// Sleeps until the given time, or until stop() is called
+  ///
+  /// \return false if the system is stopping
+  bool sleep_until(WaitClock::time_point time) {
+    std::unique_lock<std::mutex> lock(stopMutex);
+    return !stopSignal.wait_until(lock, time, [this]() { return !running; });
+  }
 
-    while (true) {
-      // Sleep
-      sleep_random();
+  /// Sleeps until the given time, until stop() is called, or until the
+  /// pool retires the worker
+  ///
+  /// \return false if the system is stopping or the worker is retired
+  bool sleep_until(WaitClock::time_point time, const std::atomic<bool> &active) {
+    std::unique_lock<std::mutex> lock(stopMutex);
+    return !stopSignal.wait_until(lock, time, [this, &active]() { return !running || !active; });
+  }
 
-      // Generate a random number
-      item = item_dist(generator);
+  /// Wakes every sleeping worker to check whether it should still run
+  void wake_sleepers() {
+    {
+      // Taking the lock orders the wakeup after the flag a sleeper checks
+      std::lock_guard<std::mutex> lock(stopMutex);
+    }
+    stopSignal.notify_all();
+  }
 
-      // Try to insert item
-      try {
-        ringBuffer.get().enqueue_sync(item);
-
-        // Print logging
-        std::stringstream message;
-        message << "Producer #" << producer_id
-                << ": Produced item " << item << std::endl;
-        std::cout << message.str();
-      } catch (std::exception &e) {
-        std::stringstream message;
-        message << "Producer #" << producer_id
-                << ": Error producing value " << item << std::endl;
-        std::cerr << message.str();
+  /// Gives a profile without a seed a random one, so it can be reported and replayed
+  static void pick_seed(LoadProfile &profile) {
+    while (profile.seed == 0) {
+      std::random_device device;
+      profile.seed = (static_cast<uint64_t>(device()) << 32) | device();
+    }
+  }
+
+  /// Moves the ring, or each shard, to the NUMA node of the consumer that
+  /// drains it. Only matters with a placement and more than one node.
+  void place_buffers() {
+    if (placement.get_mode() == ThreadPlacement::NONE || placement.num_nodes() < 2) return;
+    // Only the minimum number of consumers is sure to be running
+    if (consumerPolicy.minWorkers == 0) return;
+
+    if (shardedBuffer) {
+      for (size_t shard = 0; shard < shardedBuffer->size(); ++shard) {
+        int cpu = placement.consumer_cpu(shard % consumerPolicy.minWorkers, NUM_PRODUCER_THREADS);
+        shardedBuffer->place_shard_on_node(shard, placement.node_of(cpu));
+      }
+    } else {
+      ringBuffer->place_on_node(placement.node_of(placement.consumer_cpu(0, NUM_PRODUCER_THREADS)));
+    }
+  }
+
+  /// Inserts items into RingBuffer
+  ///
+  /// \param producer_id the id of the producer
+  /// \param log the producer's own log channel
+  void producer(size_t producer_id, AsyncLogger::Channel &log) {
+    // Each producer has its own stream of the seed, for arrivals and for items
+    ArrivalSchedule arrivals(producerLoad, producer_id);
+    ItemGenerator<T> generate(producerLoad.seed, producer_id);
+
+    // Buffer items
+    T items[ARRIVAL_BATCH];
+
+    pin_current_thread(placement.producer_cpu(producer_id));
+
+    while (running) {
+      // Sleep until the next arrival, then make every item that is due
+      if (!sleep_until(arrivals.next())) break;
+      size_t due = arrivals.take_due(WaitClock::now(), ARRIVAL_BATCH);
+      generate.fill(items, due);
+
+      // Try to insert the items, giving up if the system stops while the buffer is full
+      for (size_t i = 0; i < due && running; ++i) {
+        try {
+          bool inserted = false;
+          while (running && !inserted) inserted = enqueue_for(producer_id, items[i], std::chrono::milliseconds(100));
+          if (inserted) log.log(LOG_INFO, PRODUCED, static_cast<uint32_t>(producer_id), items[i]);
+        } catch (std::exception &e) {
+          log.log(LOG_ERROR, PRODUCE_FAILED, static_cast<uint32_t>(producer_id), items[i]);
+        }
       }
     }
   }
@@ -80,28 +195,36 @@ class ProducerConsumer {
   /// Removes items from RingBuffer
   ///
   /// \param consumer_id the id of the consumer
-  void consumer(size_t consumer_id) {
+  /// \param log the consumer's own log channel
+  /// \param active turned off when the pool retires this consumer
+  void consumer(size_t consumer_id, AsyncLogger::Channel &log, const std::atomic<bool> &active) {
+    // Consumer streams start past the producers', in case both share a seed
+    ArrivalSchedule arrivals(consumerLoad, (uint64_t(1) << 32) + consumer_id);
+
     // Buffer item
     T item;
 
-    while (true) {
-      // Sleep
-      sleep_random();
+    pin_current_thread(placement.consumer_cpu(consumer_id, NUM_PRODUCER_THREADS));
 
-      // Try to consume item
-      try {
-        item = ringBuffer.get().dequeue_sync();
-
-        // Print logging
-        std::stringstream message;
-        message << "Consumer #" << consumer_id
-                << ": Consumed item " << item << std::endl;
-        std::cout << message.str();
-      } catch (std::exception &e) {
-        std::stringstream message;
-        message << "Consumer #" << consumer_id
-                << ": Error trying to consume item" << std::endl;
-        std::cout << message.str();
+    while (running && active) {
+      // Sleep until the next arrival, then take one item for each that is due
+      if (!sleep_until(arrivals.next(), active)) break;
+      size_t due = arrivals.take_due(WaitClock::now(), ARRIVAL_BATCH);
+
+      // Try to consume the items, giving up if the system stops while the buffer is empty
+      for (size_t i = 0; i < due && running && active; ++i) {
+        try {
+          bool removed = false;
+          while (running && active && !removed) {
+            removed = dequeue_for(consumer_id, item, std::chrono::milliseconds(100));
+          }
+          if (removed) {
+            consumed.fetch_add(1, std::memory_order_relaxed);
+            log.log(LOG_INFO, CONSUMED, static_cast<uint32_t>(consumer_id), item);
+          }
+        } catch (std::exception &e) {
+          log.log(LOG_ERROR, CONSUME_FAILED, static_cast<uint32_t>(consumer_id));
+        }
       }
     }
   }
@@ -113,32 +236,199 @@ class ProducerConsumer {
   /// \param numProducerThreads the number of producers
   /// \param numConsumerThreads the number of consumers
   ProducerConsumer(
-      std::reference_wrapper<RingBuffer<T>> ringBuffer,
+      std::reference_wrapper<RingBuffer<T, Policy, Wait, Stats>> ringBuffer,
       size_t numProducerThreads,
       size_t numConsumerThreads
-  ) : ringBuffer(ringBuffer),
+  ) : ringBuffer(&ringBuffer.get()),
       NUM_PRODUCER_THREADS(numProducerThreads),
-      NUM_CONSUMER_THREADS(numConsumerThreads) {};
+      NUM_CONSUMER_THREADS(numConsumerThreads),
+      running(false),
+      consumerPolicy(ElasticPolicy::fixed(numConsumerThreads)),
+      consumed(0) {};
 
-  /// Starts the producer consumer system
+  /// Creates a sharded producer-consumer system.
+  /// Producer i inserts into shard i; consumer i drains shard i first and
+  /// steals from the others when it is empty.
+  ///
+  /// \param shardedBuffer the shards, usually one per producer
+  /// \param numProducerThreads the number of producers
+  /// \param numConsumerThreads the number of consumers
+  ProducerConsumer(
+      std::reference_wrapper<ShardedBuffer> shardedBuffer,
+      size_t numProducerThreads,
+      size_t numConsumerThreads
+  ) : shardedBuffer(&shardedBuffer.get()),
+      NUM_PRODUCER_THREADS(numProducerThreads),
+      NUM_CONSUMER_THREADS(numConsumerThreads),
+      running(false),
+      consumerPolicy(ElasticPolicy::fixed(numConsumerThreads)),
+      consumed(0) {};
+
+  ProducerConsumer(const ProducerConsumer &) = delete;
+  ProducerConsumer &operator=(const ProducerConsumer &) = delete;
+
+  /// Stops the workers started by start()
+  ~ProducerConsumer() {
+    stop();
+  }
+
+  /// Sets which CPUs the producers and consumers run on, for start() and run().
+  /// With more than one NUMA node, the buffer moves to its consumer's node.
+  void set_placement(const ThreadPlacement &newPlacement) {
+    placement = newPlacement;
+  }
+
+  /// Lets the number of consumers follow the load, for start() and run().
+  /// The pool adds consumers while the buffer fills up or items wait too
+  /// long, and retires them after the buffer has stayed nearly empty.
+  /// Takes effect at the next start() or run().
+  ///
+  /// \param policy the consumer limits and thresholds; at least one consumer
+  void set_elastic(const ElasticPolicy &policy) {
+    consumerPolicy = policy;
+    consumerPolicy.minWorkers = std::max<size_t>(policy.minWorkers, 1);
+    consumerPolicy.maxWorkers = std::max(consumerPolicy.minWorkers, policy.maxWorkers);
+  }
+
+  /// Sets when the workers started by start() produce and consume items.
+  /// Both default to a uniform 250-500 ms between items. Profiles without
+  /// a seed get a random one at start(); pass the same seeds again to
+  /// replay a run's items and timing.
+  ///
+  /// \param producers the arrival process of each producer
+  /// \param consumers the arrival process of each consumer
+  /// \throws std::invalid_argument if either profile is invalid; neither is set
+  void set_load(const LoadProfile &producers, const LoadProfile &consumers) {
+    producers.validate();
+    consumers.validate();
+    producerLoad = producers;
+    consumerLoad = consumers;
+  }
+
+  /// Returns the producers' load profile, with the seed used once started
+  const LoadProfile &producer_load() const {
+    return producerLoad;
+  }
+
+  /// Returns the consumers' load profile, with the seed used once started
+  const LoadProfile &consumer_load() const {
+    return consumerLoad;
+  }
+
+  /// Returns the consumer pool of the last start() or run(), or nullptr before either
+  const ElasticPool *consumer_pool() const {
+    return consumers.get();
+  }
+
+  /// Sets how much the workers started by start() log
+  ///
+  /// \param level the lowest level kept, LOG_OFF for none
+  /// \param sampleEvery keep one in this many item records
+  void set_logging(LogLevel level, unsigned int sampleEvery = 1) {
+    logger.set_level(level);
+    logger.set_sampling(sampleEvery);
+  }
+
+  /// Returns a snapshot of the shared ring's counters; sharded mode keeps none
+  RingStats stats() {
+    return ringBuffer ? ringBuffer->stats() : RingStats();
+  }
+
+  /// Starts the producer consumer system. The threads run until stop().
   void start() {
+    if (running.exchange(true)) return;
+    pick_seed(producerLoad);
+    pick_seed(consumerLoad);
+    place_buffers();
+    logger.start();
+
     // Create the producers
     for (size_t i = 0; i < NUM_PRODUCER_THREADS; ++i) {
       try {
-        std::thread(&ProducerConsumer<T>::producer, this, i).detach();
+        workers.emplace_back(&ProducerConsumer::producer, this, i, std::ref(logger.channel()));
       } catch (std::system_error &e) {
         std::cerr << "Error: Could not create producer #" << i << std::endl;
       }
     }
 
-    // Create the consumers
-    for (size_t i = 0; i < NUM_CONSUMER_THREADS; ++i) {
-      try {
-        std::thread(&ProducerConsumer<T>::consumer, this, i).detach();
-      } catch (std::system_error &e) {
-        std::cerr << "Error: Could not create producer #" << i << std::endl;
-      }
+    // Create the consumers, with a log channel for every one the pool may start
+    while (consumerLogs.size() < consumerPolicy.maxWorkers) consumerLogs.push_back(&logger.channel());
+    make_consumers([this](size_t i, const std::atomic<bool> &active) {
+      consumer(i, *consumerLogs[i], active);
+    });
+    try {
+      consumers->start();
+    } catch (std::system_error &e) {
+      std::cerr << "Error: Could not create consumers" << std::endl;
+    }
+  }
+
+  /// Stops the threads started by start() and waits for them to finish.
+  /// Items still in the buffer stay there. Safe to call more than once.
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(stopMutex);
+      if (!running.exchange(false)) return;
     }
+    stopSignal.notify_all();
+
+    for (std::thread &worker : workers) worker.join();
+    workers.clear();
+    if (consumers) consumers->stop();
+    logger.stop();
+  }
+
+  /// Runs the system flat out until a fixed number of items has gone through.
+  /// Unlike start(), nothing sleeps or logs, and the call returns once every
+  /// thread has finished. Needs at least one consumer. Consumer ids go up to
+  /// the elastic maximum, if set_elastic() was called.
+  ///
+  /// \param itemsPerProducer the number of items each producer inserts
+  /// \param generate makes the next item for a producer, given its id
+  /// \param handle called by a consumer, given its id, for every removed item
+  void run(
+      size_t itemsPerProducer,
+      const std::function<T(size_t)> &generate,
+      const std::function<void(size_t, T &)> &handle
+  ) {
+    std::atomic<size_t> remaining(itemsPerProducer * NUM_PRODUCER_THREADS);
+    std::mutex doneMutex;
+    std::condition_variable done;
+    std::vector<std::thread> threads;
+    place_buffers();
+
+    for (size_t i = 0; i < NUM_PRODUCER_THREADS; ++i) {
+      threads.emplace_back([&, i]() {
+        pin_current_thread(placement.producer_cpu(i));
+        for (size_t n = 0; n < itemsPerProducer; ++n) {
+          enqueue(i, generate(i));
+        }
+      });
+    }
+
+    make_consumers([&](size_t i, const std::atomic<bool> &active) {
+      pin_current_thread(placement.consumer_cpu(i, NUM_PRODUCER_THREADS));
+      T item;
+      // Time out now and then so consumers notice when everything is done
+      while (active && remaining.load(std::memory_order_relaxed) > 0) {
+        if (dequeue_for(i, item, std::chrono::milliseconds(10))) {
+          handle(i, item);
+          consumed.fetch_add(1, std::memory_order_relaxed);
+          if (remaining.fetch_sub(1, std::memory_order_relaxed) == 1) {
+            std::lock_guard<std::mutex> lock(doneMutex);
+            done.notify_all();
+          }
+        }
+      }
+    });
+    consumers->start();
+
+    for (std::thread &thread : threads) thread.join();
+
+    std::unique_lock<std::mutex> lock(doneMutex);
+    done.wait(lock, [&]() { return remaining.load() == 0; });
+    lock.unlock();
+    consumers->stop();
   }
 };
 
@@ -0,0 +1,209 @@
+//
+// Created by Peter on 10/17/2026.
+//
+
+#ifndef CSCI411_QUEUESTATS_H
+#define CSCI411_QUEUESTATS_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "WaitStrategy.h"
+
+// Stats policies decide whether a RingBuffer counts what it does. Both have
+// the same interface, and every NoStats call is an empty inline function,
+// so a RingBuffer<T, Policy, Wait, NoStats> compiles to the same code as
+// one without any counters. Cores with mutexes take them through a
+// LockCounter<Stats::ENABLED>, which without stats is a plain lock().
+
+/// Locks a mutex, counting the times another thread already held it
+template<bool Enabled>
+class LockCounter;
+
+template<>
+class LockCounter<true> {
+ private:
+  uint64_t contended = 0;  // Guarded by the mutex being counted
+
+ public:
+  std::unique_lock<std::mutex> acquire(std::mutex &mutex) {
+    std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+      lock.lock();
+      contended++;
+    }
+    return lock;
+  }
+
+  /// Returns the acquisitions that had to wait for another thread
+  uint64_t contentions(std::mutex &mutex) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return contended;
+  }
+};
+
+template<>
+class LockCounter<false> {
+ public:
+  std::unique_lock<std::mutex> acquire(std::mutex &mutex) {
+    return std::unique_lock<std::mutex>(mutex);
+  }
+
+  uint64_t contentions(std::mutex &) { return 0; }
+};
+
+/// Snapshot of a RingBuffer's counters
+struct RingStats {
+  static const size_t OCCUPANCY_BUCKETS = 11;
+
+  uint64_t enqueues = 0, dequeues = 0;
+  uint64_t blockedEnqueues = 0, blockedDequeues = 0;  // Operations that had to wait
+  uint64_t enqueueWaitNs = 0, dequeueWaitNs = 0;      // Total time spent waiting
+  uint64_t maxEnqueueWaitNs = 0, maxDequeueWaitNs = 0;
+  uint64_t contentions = 0;                           // Mutex acquisitions that found it held
+
+  /// Sampled occupancy: bucket i counts samples with i tenths of the buffer
+  /// full, bucket 10 counts a full buffer
+  std::vector<uint64_t> occupancy = std::vector<uint64_t>(OCCUPANCY_BUCKETS, 0);
+};
+
+/// Counts nothing
+struct NoStats {
+  static const bool ENABLED = false;
+
+  uint64_t wait_begin() const { return 0; }
+
+  void enqueue_waited(uint64_t) {}
+
+  void dequeue_waited(uint64_t) {}
+
+  template<typename Core>
+  void enqueued(size_t, Core &) {}
+
+  void dequeued(size_t) {}
+
+  RingStats snapshot() const { return RingStats(); }
+
+  void reset() {}
+};
+
+/// Counts operations, waits and occupancy in per-thread slots.
+/// Each thread updates its own cache line, so counting never contends; a
+/// snapshot adds up the slots. Threads beyond SLOTS share slots, which is
+/// still correct for the totals but may lose an update to a maximum.
+class QueueStats {
+ private:
+  static const size_t SLOTS = 64;
+  static const unsigned int OCCUPANCY_SAMPLE = 16;  // Sample one in this many enqueues
+
+  struct alignas(CACHE_LINE_SIZE) Slot {
+    std::atomic<uint64_t> enqueues, dequeues;
+    std::atomic<uint64_t> blockedEnqueues, blockedDequeues;
+    std::atomic<uint64_t> enqueueWaitNs, dequeueWaitNs;
+    std::atomic<uint64_t> maxEnqueueWaitNs, maxDequeueWaitNs;
+    std::atomic<uint64_t> occupancy[RingStats::OCCUPANCY_BUCKETS];
+
+    Slot() { clear(); }
+
+    void clear() {
+      enqueues = dequeues = 0;
+      blockedEnqueues = blockedDequeues = 0;
+      enqueueWaitNs = dequeueWaitNs = 0;
+      maxEnqueueWaitNs = maxDequeueWaitNs = 0;
+      for (std::atomic<uint64_t> &bucket : occupancy) bucket = 0;
+    }
+  };
+
+  Slot slots[SLOTS];
+
+  /// Returns the calling thread's slot
+  Slot &slot() {
+    static std::atomic<size_t> nextSlot(0);
+    static thread_local size_t mine = nextSlot.fetch_add(1, std::memory_order_relaxed);
+    return slots[mine % SLOTS];
+  }
+
+  static uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        WaitClock::now().time_since_epoch()).count());
+  }
+
+  static void add(std::atomic<uint64_t> &counter, uint64_t value) {
+    counter.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  static void raise(std::atomic<uint64_t> &maximum, uint64_t value) {
+    if (value > maximum.load(std::memory_order_relaxed)) maximum.store(value, std::memory_order_relaxed);
+  }
+
+ public:
+  static const bool ENABLED = true;
+
+  /// Returns the start time of a wait
+  uint64_t wait_begin() const {
+    return now_ns();
+  }
+
+  /// Records an enqueue that had to wait since the given start time
+  void enqueue_waited(uint64_t since) {
+    uint64_t waited = now_ns() - since;
+    Slot &mine = slot();
+    add(mine.blockedEnqueues, 1);
+    add(mine.enqueueWaitNs, waited);
+    raise(mine.maxEnqueueWaitNs, waited);
+  }
+
+  /// Records a dequeue that had to wait since the given start time
+  void dequeue_waited(uint64_t since) {
+    uint64_t waited = now_ns() - since;
+    Slot &mine = slot();
+    add(mine.blockedDequeues, 1);
+    add(mine.dequeueWaitNs, waited);
+    raise(mine.maxDequeueWaitNs, waited);
+  }
+
+  /// Records inserted items, now and then sampling how full the core is
+  template<typename Core>
+  void enqueued(size_t count, Core &core) {
+    Slot &mine = slot();
+    uint64_t before = mine.enqueues.fetch_add(count, std::memory_order_relaxed);
+    if ((before + count) / OCCUPANCY_SAMPLE != before / OCCUPANCY_SAMPLE) {
+      size_t bucket = core.size() * 10 / core.capacity();
+      add(mine.occupancy[bucket < RingStats::OCCUPANCY_BUCKETS ? bucket : RingStats::OCCUPANCY_BUCKETS - 1], 1);
+    }
+  }
+
+  /// Records removed items
+  void dequeued(size_t count) {
+    add(slot().dequeues, count);
+  }
+
+  /// Adds up every thread's counters
+  RingStats snapshot() const {
+    RingStats result;
+    for (const Slot &each : slots) {
+      result.enqueues += each.enqueues.load(std::memory_order_relaxed);
+      result.dequeues += each.dequeues.load(std::memory_order_relaxed);
+      result.blockedEnqueues += each.blockedEnqueues.load(std::memory_order_relaxed);
+      result.blockedDequeues += each.blockedDequeues.load(std::memory_order_relaxed);
+      result.enqueueWaitNs += each.enqueueWaitNs.load(std::memory_order_relaxed);
+      result.dequeueWaitNs += each.dequeueWaitNs.load(std::memory_order_relaxed);
+      result.maxEnqueueWaitNs = std::max(result.maxEnqueueWaitNs, each.maxEnqueueWaitNs.load(std::memory_order_relaxed));
+      result.maxDequeueWaitNs = std::max(result.maxDequeueWaitNs, each.maxDequeueWaitNs.load(std::memory_order_relaxed));
+      for (size_t i = 0; i < RingStats::OCCUPANCY_BUCKETS; ++i) {
+        result.occupancy[i] += each.occupancy[i].load(std::memory_order_relaxed);
+      }
+    }
+    return result;
+  }
+
+  /// Zeroes every counter. Updates racing with the reset may survive it.
+  void reset() {
+    for (Slot &each : slots) each.clear();
+  }
+};
+
+#endif //CSCI411_QUEUESTATS_H
@@ -5,81 +5,434 @@
 #ifndef CSCI411_RINGBUFFER_H
 #define CSCI411_RINGBUFFER_H
 
+#include <algorithm>
+#include <chrono>
 #include <cstdlib>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <memory>
+#include <new>
+#include <utility>
 #include <thread>
 #include <mutex>
 #include <pthread.h>
-#include <semaphore.h>
+#include "WaitStrategy.h"
+#include "ThreadPlacement.h"
+#include "QueueStats.h"
 
+/// Synchronization policies for RingBuffer
+struct Locking {};  ///< Mutex protected, any number of producers and consumers
+struct Spsc {};     ///< Lock-free, exactly one producer thread and one consumer thread
+struct Mpmc {};     ///< Lock-free, any number of producers and consumers
+struct Unbounded {};///< Linked segments that grow instead of blocking producers
+
+/// Base for heap allocated objects with cache-line aligned members.
+/// Plain new does not honor alignment beyond max_align_t before C++17.
+struct CacheAligned {
+  static void *operator new(size_t size) {
+    void *memory;
+    if (posix_memalign(&memory, CACHE_LINE_SIZE, size) != 0) throw std::bad_alloc();
+    return memory;
+  }
+
+  static void operator delete(void *memory) {
+    free(memory);
+  }
+};
+
+/// Rounds the size up to the next power of two
+inline size_t next_power_of_two(size_t size) {
+  size_t result = 1;
+  while (result < size) result <<= 1;
+  return result;
+}
+
+/// Allocates room for count items without constructing any of them
 template<typename T>
-class RingBuffer {
+T *allocate_items(size_t count) {
+  return static_cast<T *>(::operator new(sizeof(T) * count));
+}
+
+/// Destroys count items in place
+template<typename T>
+void destroy_items(T *first, size_t count) {
+  for (size_t i = 0; i < count; ++i) first[i].~T();
+}
+
+/// Moves count items to out and destroys them as they leave the ring
+///
+/// \return out advanced past the last item written
+template<typename T, typename OutputIt>
+OutputIt move_out(T *first, size_t count, OutputIt out) {
+  out = std::move(first, first + count, out);
+  destroy_items(first, count);
+  return out;
+}
+
+/// Non-blocking storage and indexing for a RingBuffer, one per policy.
+/// emplace/pop and their bulk forms either succeed immediately or report
+/// that the buffer is full or empty; RingBuffer adds the waiting. Cores
+/// with mutexes only count contention when Stats is enabled.
+///
+/// Slots are raw storage: an item is constructed in place when it enters
+/// the ring and moved out and destroyed when it leaves, so only live items
+/// hold resources.
+template<typename T, typename Policy, typename Stats = NoStats>
+class RingCore;
+
+/// Mutex protected ring, safe for any number of producers and consumers
+template<typename T, typename Stats>
+class RingCore<T, Locking, Stats> {
  private:
   const unsigned int BUFFER_SIZE;
   T *buffer;
 
-  int insertIdx = 0, removeIdx = 0;
+  unsigned int insertIdx = 0, removeIdx = 0, count = 0;
   std::mutex buffer_mutex;
-  sem_t emptySlots, fullSlots;
+  LockCounter<Stats::ENABLED> contended;
 
-  /// Initializes the buffer and semaphores
-  void initialize() {
-    this->buffer = new T[BUFFER_SIZE];
-    sem_init(&fullSlots, 0, 0);
-    sem_init(&emptySlots, 0, BUFFER_SIZE);
+  /// Locks the buffer
+  std::unique_lock<std::mutex> acquire() {
+    return contended.acquire(buffer_mutex);
   }
 
  public:
-  /// Creates a new RingBuffer of size 10
-  RingBuffer() : BUFFER_SIZE(10) {
-    initialize();
-  };
+  explicit RingCore(unsigned int bufferSize)
+      : BUFFER_SIZE(bufferSize), buffer(allocate_items<T>(bufferSize)) {};
 
-  /// Creates a new RingBuffer with the specified size
-  explicit RingBuffer(unsigned int bufferSize) : BUFFER_SIZE(bufferSize) {
-    initialize();
-  };
+  /// Returns the slot storage, so it can be placed on a NUMA node
+  const void *storage() const { return buffer; }
+
+  size_t storage_size() const { return sizeof(T) * BUFFER_SIZE; }
 
-  ~RingBuffer() {
-    delete[] buffer;
+  size_t capacity() const { return BUFFER_SIZE; }
+
+  /// Returns the number of items in the buffer
+  size_t size() {
+    std::lock_guard<std::mutex> lock(buffer_mutex);
+    return count;
   }
 
-  /// Inserts an item into the ring buffer.
-  /// Blocks the current thread until there is room in the buffer.
-  void enqueue_sync(T item) {
-    // Wait if there is no space left
-    sem_wait(&emptySlots);
+  /// Returns the number of lock acquisitions that had to wait for another thread
+  uint64_t contentions() {
+    return contended.contentions(buffer_mutex);
+  }
 
-    // Insert the item
-    buffer_mutex.lock();
-    buffer[insertIdx] = item;
+  ~RingCore() {
+    // Destroy the items still in the ring, which may wrap around the end
+    size_t span = std::min<size_t>(count, BUFFER_SIZE - removeIdx);
+    destroy_items(buffer + removeIdx, span);
+    destroy_items(buffer, count - span);
+    ::operator delete(buffer);
+  }
+
+  /// Constructs an item in place if there is room
+  ///
+  /// \return false if the buffer is full, leaving args untouched
+  template<typename... Args>
+  bool emplace(Args &&... args) {
+    std::unique_lock<std::mutex> lock = acquire();
+    if (count == BUFFER_SIZE) return false;
+
+    new(buffer + insertIdx) T(std::forward<Args>(args)...);
     insertIdx++;
     if (insertIdx == BUFFER_SIZE) insertIdx = 0;
-    buffer_mutex.unlock();
+    count++;
+    return true;
+  }
+
+  /// Moves an item out if there is one
+  ///
+  /// \return false if the buffer is empty
+  bool pop(T &item) {
+    std::unique_lock<std::mutex> lock = acquire();
+    if (count == 0) return false;
+
+    item = std::move(buffer[removeIdx]);
+    buffer[removeIdx].~T();
+    removeIdx++;
+    if (removeIdx == BUFFER_SIZE) removeIdx = 0;
+    count--;
+    return true;
+  }
+
+  /// Inserts as many of the next n items as fit, in at most two spans
+  ///
+  /// \return the number of items inserted, 0 if the buffer is full
+  template<typename ForwardIt>
+  size_t push_bulk(ForwardIt &first, size_t n) {
+    std::unique_lock<std::mutex> lock = acquire();
+    n = std::min<size_t>(n, BUFFER_SIZE - count);
+
+    size_t span = std::min<size_t>(n, BUFFER_SIZE - insertIdx);
+    std::uninitialized_copy_n(first, span, buffer + insertIdx);
+    std::advance(first, span);
+    std::uninitialized_copy_n(first, n - span, buffer);
+    std::advance(first, n - span);
+
+    insertIdx = static_cast<unsigned int>((insertIdx + n) % BUFFER_SIZE);
+    count += n;
+    return n;
+  }
+
+  /// Moves up to max items out into out, in at most two spans
+  ///
+  /// \return the number of items removed, 0 if the buffer is empty
+  template<typename OutputIt>
+  size_t pop_bulk(OutputIt out, size_t max) {
+    std::unique_lock<std::mutex> lock = acquire();
+    size_t n = std::min<size_t>(max, count);
+
+    size_t span = std::min<size_t>(n, BUFFER_SIZE - removeIdx);
+    out = move_out(buffer + removeIdx, span, out);
+    move_out(buffer, n - span, out);
+
+    removeIdx = static_cast<unsigned int>((removeIdx + n) % BUFFER_SIZE);
+    count -= n;
+    return n;
+  }
+};
+
+/// Bounded FIFO queue shared between producer and consumer threads
+///
+/// \tparam T the item type
+/// \tparam Policy how producers and consumers synchronize (Locking, Spsc or Mpmc)
+/// \tparam Wait what a thread does while the buffer is full or empty
+///              (BlockingWait, SpinParkWait or BusySpinWait)
+/// \tparam Stats whether to count operations, waits and occupancy
+///               (NoStats or QueueStats)
+template<typename T, typename Policy = Locking, typename Wait = BlockingWait, typename Stats = NoStats>
+class RingBuffer {
+ protected:
+  // Open to subclasses that add other ways to wait, like AsyncRingBuffer
+  RingCore<T, Policy, Stats> core;
+  Wait notFull, notEmpty;
+  Stats counters;
+
+ private:
+  // With Stats enabled, blocking operations try once before waiting so the
+  // stats can tell a wait from a hand-off. Without, they go straight to the
+  // wait strategy, which tries first anyway.
+
+  /// Waits for room, constructs the item in place, then wakes a consumer
+  template<typename... Args>
+  void insert(Args &&... args) {
+    if (!(Stats::ENABLED && core.emplace(std::forward<Args>(args)...))) {
+      uint64_t since = counters.wait_begin();
+      notFull.wait([&]() { return core.emplace(std::forward<Args>(args)...); });
+      counters.enqueue_waited(since);
+    }
+    counters.enqueued(1, core);
+    notEmpty.notify();
+  }
+
+  /// Constructs the item in place if there is room, without waiting
+  template<typename... Args>
+  bool try_insert(Args &&... args) {
+    if (!core.emplace(std::forward<Args>(args)...)) return false;
+    counters.enqueued(1, core);
+    notEmpty.notify();
+    return true;
+  }
+
+  /// Waits until the deadline for room, then constructs the item in place
+  template<typename... Args>
+  bool insert_until(WaitClock::time_point deadline, Args &&... args) {
+    if (!(Stats::ENABLED && core.emplace(std::forward<Args>(args)...))) {
+      uint64_t since = counters.wait_begin();
+      bool inserted = notFull.wait_until([&]() { return core.emplace(std::forward<Args>(args)...); }, deadline);
+      counters.enqueue_waited(since);
+      if (!inserted) return false;
+    }
+    counters.enqueued(1, core);
+    notEmpty.notify();
+    return true;
+  }
 
-    // Increment the count of the number of items
-    sem_post(&fullSlots);
+  /// Waits for an item, moves it out, then wakes a producer
+  void remove(T &item) {
+    if (!(Stats::ENABLED && core.pop(item))) {
+      uint64_t since = counters.wait_begin();
+      notEmpty.wait([&]() { return core.pop(item); });
+      counters.dequeue_waited(since);
+    }
+    counters.dequeued(1);
+    notFull.notify();
+  }
+
+  /// Waits until the deadline for an item, then moves it out
+  bool remove_until(WaitClock::time_point deadline, T &item) {
+    if (!(Stats::ENABLED && core.pop(item))) {
+      uint64_t since = counters.wait_begin();
+      bool removed = notEmpty.wait_until([&]() { return core.pop(item); }, deadline);
+      counters.dequeue_waited(since);
+      if (!removed) return false;
+    }
+    counters.dequeued(1);
+    notFull.notify();
+    return true;
+  }
+
+ public:
+  /// Creates a new RingBuffer of size 10
+  RingBuffer() : core(10) {};
+
+  /// Creates a new RingBuffer with the specified size.
+  /// Lock-free policies round the size up to the next power of two, and
+  /// Unbounded uses it as the size of each segment.
+  explicit RingBuffer(unsigned int bufferSize) : core(bufferSize) {};
+
+  /// Calls a callback when an Unbounded buffer grows to a number of items.
+  /// Set it before any thread uses the buffer.
+  ///
+  /// \param mark the number of items, 0 to turn the callback off
+  /// \param callback called by the inserting thread with the current size
+  template<typename P = Policy>
+  typename std::enable_if<std::is_same<P, Unbounded>::value>::type
+  set_high_water(size_t mark, const std::function<void(size_t)> &callback = std::function<void(size_t)>()) {
+    core.set_high_water(mark, callback);
+  }
+
+  /// Moves the ring's slots to a NUMA node, ideally its consumer's
+  void place_on_node(int node) {
+    bind_to_node(core.storage(), core.storage_size(), node);
+  }
+
+  /// Inserts a copy of an item into the ring buffer.
+  /// Waits until there is room in the buffer.
+  void enqueue_sync(const T &item) {
+    insert(item);
   };
 
-  /// Removes an item from the ring buffer.
-  /// Blocks the current thread until there is an item in the buffer.
+  /// Moves an item into the ring buffer.
+  /// Waits until there is room in the buffer.
+  void enqueue_sync(T &&item) {
+    insert(std::move(item));
+  };
+
+  /// Constructs an item in place in the ring buffer from args.
+  /// Waits until there is room in the buffer.
+  template<typename... Args>
+  void emplace(Args &&... args) {
+    insert(std::forward<Args>(args)...);
+  };
+
+  /// Removes an item from the ring buffer, moving it out.
+  /// Waits until there is an item in the buffer.
   ///
   /// \return the earliest item in the buffer
   T dequeue_sync() {
-    // Wait if there are no items in the buffer
-    sem_wait(&fullSlots);
+    T result;
+    remove(result);
+    return result;
+  };
 
-    // Get the item
-    buffer_mutex.lock();
-    T result = buffer[removeIdx];
-    removeIdx++;
-    if (removeIdx == BUFFER_SIZE) removeIdx = 0;
-    buffer_mutex.unlock();
+  /// Inserts a copy of an item if there is room, without waiting
+  ///
+  /// \return false if the buffer is full
+  bool try_enqueue(const T &item) {
+    return try_insert(item);
+  }
+
+  /// Moves an item in if there is room, without waiting
+  ///
+  /// \return false if the buffer is full, leaving item untouched
+  bool try_enqueue(T &&item) {
+    return try_insert(std::move(item));
+  }
 
-    // Increment the number of empty slots
-    sem_post(&emptySlots);
+  /// Removes an item if there is one, without waiting
+  ///
+  /// \param item set to the earliest item in the buffer
+  /// \return false if the buffer is empty
+  bool try_dequeue(T &item) {
+    if (!core.pop(item)) return false;
+    counters.dequeued(1);
+    notFull.notify();
+    return true;
+  }
 
-    return result;
+  /// Inserts a copy of an item, waiting at most timeout for room in the buffer
+  ///
+  /// \return false if the buffer stayed full
+  template<typename Rep, typename Period>
+  bool enqueue_for(const T &item, const std::chrono::duration<Rep, Period> &timeout) {
+    return insert_until(WaitClock::now() + timeout, item);
+  }
+
+  /// Moves an item in, waiting at most timeout for room in the buffer
+  ///
+  /// \return false if the buffer stayed full, leaving item untouched
+  template<typename Rep, typename Period>
+  bool enqueue_for(T &&item, const std::chrono::duration<Rep, Period> &timeout) {
+    return insert_until(WaitClock::now() + timeout, std::move(item));
+  }
+
+  /// Removes an item, waiting at most timeout for one to arrive
+  ///
+  /// \param item set to the earliest item in the buffer
+  /// \return false if the buffer stayed empty
+  template<typename Rep, typename Period>
+  bool dequeue_for(T &item, const std::chrono::duration<Rep, Period> &timeout) {
+    return remove_until(WaitClock::now() + timeout, item);
+  }
+
+  /// Inserts copies of a range of items into the ring buffer; wrap the range
+  /// in std::make_move_iterator to move them instead.
+  /// Waits until every item has been inserted. Items go in runs of as many
+  /// free slots as are available, each run claimed and published at once.
+  template<typename ForwardIt>
+  void enqueue_bulk(ForwardIt first, ForwardIt last) {
+    size_t remaining = static_cast<size_t>(std::distance(first, last));
+    while (remaining > 0) {
+      size_t count = 0;
+      notFull.wait([&]() { return (count = core.push_bulk(first, remaining)) > 0; });
+      counters.enqueued(count, core);
+      notEmpty.notify();
+      remaining -= count;
+    }
   };
+
+  /// Moves up to max items out of the ring buffer.
+  /// Waits until there is at least one item in the buffer, then removes as
+  /// many as are available.
+  ///
+  /// \param out where to write the removed items
+  /// \param max the most items to remove
+  /// \return the number of items removed
+  template<typename OutputIt>
+  size_t dequeue_bulk(OutputIt out, size_t max) {
+    if (max == 0) return 0;
+    size_t count = 0;
+    notEmpty.wait([&]() { return (count = core.pop_bulk(out, max)) > 0; });
+    counters.dequeued(count);
+    notFull.notify();
+    return count;
+  };
+
+  /// Returns the number of items in the buffer; only a hint while other
+  /// threads are inserting or removing
+  size_t size() {
+    return core.size();
+  }
+
+  /// Returns the number of items the buffer holds
+  size_t capacity() const {
+    return core.capacity();
+  }
+
+  /// Returns a snapshot of the counters, all zero unless Stats is QueueStats
+  RingStats stats() {
+    RingStats result = counters.snapshot();
+    result.contentions = core.contentions();
+    return result;
+  }
+
+  /// Zeroes the counters kept by Stats
+  void reset_stats() {
+    counters.reset();
+  }
 };
 
 #endif //CSCI411_RINGBUFFER_H
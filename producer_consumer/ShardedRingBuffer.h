@@ -0,0 +1,152 @@
+//
+// Created by Peter on 10/17/2026.
+//
+
+#ifndef CSCI411_SHARDEDRINGBUFFER_H
+#define CSCI411_SHARDEDRINGBUFFER_H
+
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include "RingBuffer.h"
+
+/// A set of RingBuffers, one per producer, with work stealing consumers.
+/// Producers only touch their own shard, so they never contend with each
+/// other. A consumer drains its home shard first and steals from the other
+/// shards, in order, when its home shard is empty. Items keep their FIFO
+/// order within a shard.
+///
+/// \tparam T the item type
+/// \tparam Policy the shard policy; stealing means several consumers per shard,
+///                so Locking or Mpmc
+/// \tparam Wait what a thread does while its shard is full or every shard is empty
+template<typename T, typename Policy = Mpmc, typename Wait = BlockingWait>
+class ShardedRingBuffer {
+  static_assert(!std::is_same<Policy, Spsc>::value,
+                "Stolen shards have more than one consumer, use Locking or Mpmc");
+
+ private:
+  struct Shard : CacheAligned {
+    RingCore<T, Policy> core;
+    Wait notFull;
+
+    explicit Shard(unsigned int shardSize) : core(shardSize) {};
+  };
+
+  std::vector<std::unique_ptr<Shard>> shards;
+  Wait notEmpty;
+
+  /// Returns the shard a producer or consumer id maps to
+  Shard &shard_for(size_t id) {
+    return *shards[id % shards.size()];
+  }
+
+  /// Removes an item from the home shard, or else the first non-empty other shard
+  ///
+  /// \return false if every shard is empty
+  bool take(size_t home, T &item) {
+    for (size_t i = 0; i < shards.size(); ++i) {
+      Shard &shard = shard_for(home + i);
+      if (shard.core.pop(item)) {
+        shard.notFull.notify();
+        return true;
+      }
+    }
+    return false;
+  }
+
+ public:
+  /// Creates the shards
+  ///
+  /// \param numShards the number of shards, usually the number of producers
+  /// \param shardSize the size of each shard's ring
+  ShardedRingBuffer(size_t numShards, unsigned int shardSize) {
+    for (size_t i = 0; i < std::max<size_t>(numShards, 1); ++i) {
+      shards.emplace_back(new Shard(shardSize));
+    }
+  };
+
+  /// Returns the number of shards
+  size_t size() const {
+    return shards.size();
+  }
+
+  /// Returns roughly the number of items in every shard together
+  size_t count() {
+    size_t total = 0;
+    for (std::unique_ptr<Shard> &shard : shards) total += shard->core.size();
+    return total;
+  }
+
+  /// Returns the number of items every shard together holds
+  size_t capacity() const {
+    size_t total = 0;
+    for (const std::unique_ptr<Shard> &shard : shards) total += shard->core.capacity();
+    return total;
+  }
+
+  /// Moves a shard's slots to a NUMA node, ideally its home consumer's
+  void place_shard_on_node(size_t shard, int node) {
+    bind_to_node(shard_for(shard).core.storage(), shard_for(shard).core.storage_size(), node);
+  }
+
+  /// Inserts an item into a producer's shard.
+  /// Waits until there is room in that shard.
+  ///
+  /// \param producer_id picks the shard
+  void enqueue_sync(size_t producer_id, T item) {
+    Shard &shard = shard_for(producer_id);
+    shard.notFull.wait([&]() { return shard.core.emplace(std::move(item)); });
+    notEmpty.notify();
+  };
+
+  /// Inserts an item into a producer's shard if there is room, without waiting
+  ///
+  /// \return false if the shard is full
+  bool try_enqueue(size_t producer_id, const T &item) {
+    if (!shard_for(producer_id).core.emplace(item)) return false;
+    notEmpty.notify();
+    return true;
+  }
+
+  /// Inserts an item into a producer's shard, waiting at most timeout for room
+  ///
+  /// \return false if the shard stayed full
+  template<typename Rep, typename Period>
+  bool enqueue_for(size_t producer_id, const T &item, const std::chrono::duration<Rep, Period> &timeout) {
+    Shard &shard = shard_for(producer_id);
+    WaitClock::time_point deadline = WaitClock::now() + timeout;
+    if (!shard.notFull.wait_until([&]() { return shard.core.emplace(item); }, deadline)) return false;
+    notEmpty.notify();
+    return true;
+  }
+
+  /// Removes an item, preferring a consumer's home shard.
+  /// Waits until there is an item in any shard.
+  ///
+  /// \param consumer_id picks the home shard
+  /// \return the earliest item of the first non-empty shard
+  T dequeue_sync(size_t consumer_id) {
+    T result;
+    notEmpty.wait([&]() { return take(consumer_id, result); });
+    return result;
+  };
+
+  /// Removes an item if any shard has one, without waiting
+  ///
+  /// \return false if every shard is empty
+  bool try_dequeue(size_t consumer_id, T &item) {
+    return take(consumer_id, item);
+  }
+
+  /// Removes an item, waiting at most timeout for one to arrive in any shard
+  ///
+  /// \return false if every shard stayed empty
+  template<typename Rep, typename Period>
+  bool dequeue_for(size_t consumer_id, T &item, const std::chrono::duration<Rep, Period> &timeout) {
+    WaitClock::time_point deadline = WaitClock::now() + timeout;
+    return notEmpty.wait_until([&]() { return take(consumer_id, item); }, deadline);
+  }
+};
+
+#endif //CSCI411_SHARDEDRINGBUFFER_H
@@ -0,0 +1,293 @@
+//
+// Created by Peter on 10/17/2026.
+//
+
+#ifndef CSCI411_SHAREDRINGBUFFER_H
+#define CSCI411_SHAREDRINGBUFFER_H
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "RingBuffer.h"
+
+/// Bounded FIFO queue in POSIX shared memory, for producers and consumers
+/// in separate processes. Items are copied straight into the mapping, so
+/// nothing passes through the kernel. Slots use the same sequence numbers
+/// as RingBuffer<T, Mpmc>, and blocked processes park on shared futexes.
+///
+/// One process creates the buffer by name; the others attach to it.
+/// Creating fails while a buffer with the name exists, unless asked to
+/// replace it, so a second owner cannot cut off a live buffer. The
+/// header records a version, the item size and the capacity, and attaching
+/// fails if any of them do not match.
+///
+/// \tparam T the item type, must be trivially copyable
+template<typename T>
+class SharedRingBuffer {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "Items in shared memory must be trivially copyable");
+
+ private:
+  static const uint32_t MAGIC = 0x52494e47;  // "RING"
+  static const uint32_t VERSION = 1;
+
+  struct Header {
+    std::atomic<uint32_t> magic;  // Written last, once the buffer is ready
+    uint32_t version;
+    uint32_t itemSize;
+    uint32_t bufferSize;
+    std::atomic<uint32_t> attached;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> insertIdx;
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> removeIdx;
+    alignas(CACHE_LINE_SIZE) SpinParkWait notFull;
+    alignas(CACHE_LINE_SIZE) SpinParkWait notEmpty;
+
+    explicit Header(uint32_t bufferSize)
+        : magic(0), version(VERSION), itemSize(sizeof(T)), bufferSize(bufferSize), attached(1),
+          insertIdx(0), removeIdx(0), notFull(true), notEmpty(true) {};
+  };
+
+  struct Slot {
+    std::atomic<uint64_t> sequence;
+    T item;
+  };
+
+  std::string name;
+  bool owner;
+  size_t mappedSize = 0;
+  Header *header = nullptr;
+  Slot *buffer = nullptr;
+  uint64_t MASK = 0;
+
+  /// Returns the size of the mapping for a buffer size
+  static size_t mapping_size(uint32_t bufferSize) {
+    return sizeof(Header) + sizeof(Slot) * bufferSize;
+  }
+
+  /// Maps a shared memory object into this process
+  void map(int fd, size_t size) {
+    void *address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) throw std::runtime_error("Could not map shared ring buffer: " + name);
+
+    mappedSize = size;
+    header = static_cast<Header *>(address);
+    buffer = reinterpret_cast<Slot *>(static_cast<char *>(address) + sizeof(Header));
+  }
+
+  /// Claims a slot and inserts an item if there is room
+  ///
+  /// \return false if the buffer is full
+  bool push(const T &item) {
+    Slot *slot;
+    uint64_t idx = header->insertIdx.load(std::memory_order_relaxed);
+
+    while (true) {
+      slot = &buffer[idx & MASK];
+      uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+      int64_t diff = static_cast<int64_t>(sequence - idx);
+
+      if (diff == 0) {
+        if (header->insertIdx.compare_exchange_weak(idx, idx + 1, std::memory_order_relaxed)) break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        idx = header->insertIdx.load(std::memory_order_relaxed);
+      }
+    }
+
+    slot->item = item;
+    slot->sequence.store(idx + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Claims a slot and removes its item if there is one
+  ///
+  /// \return false if the buffer is empty
+  bool pop(T &item) {
+    Slot *slot;
+    uint64_t idx = header->removeIdx.load(std::memory_order_relaxed);
+
+    while (true) {
+      slot = &buffer[idx & MASK];
+      uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+      int64_t diff = static_cast<int64_t>(sequence - (idx + 1));
+
+      if (diff == 0) {
+        if (header->removeIdx.compare_exchange_weak(idx, idx + 1, std::memory_order_relaxed)) break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        idx = header->removeIdx.load(std::memory_order_relaxed);
+      }
+    }
+
+    item = slot->item;
+    slot->sequence.store(idx + MASK + 1, std::memory_order_release);
+    return true;
+  }
+
+ public:
+  /// Creates a new shared buffer. The size is rounded up to the next power
+  /// of two.
+  ///
+  /// \param name the shared memory name, starting with '/'
+  /// \param bufferSize the number of slots
+  /// \param replace if true, removes a buffer left with the same name, such
+  ///                as by a crashed owner, instead of failing. Processes
+  ///                still attached to it are cut off from the new one.
+  SharedRingBuffer(const std::string &name, unsigned int bufferSize, bool replace = false)
+      : name(name), owner(true) {
+    uint32_t size = static_cast<uint32_t>(next_power_of_two(bufferSize));
+
+    if (replace) shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0660);
+    if (fd == -1 && errno == EEXIST) throw std::runtime_error("Shared ring buffer already exists: " + name);
+    if (fd == -1) throw std::runtime_error("Could not create shared ring buffer: " + name);
+    if (ftruncate(fd, static_cast<off_t>(mapping_size(size))) == -1) {
+      close(fd);
+      shm_unlink(name.c_str());
+      throw std::runtime_error("Could not size shared ring buffer: " + name);
+    }
+    try {
+      map(fd, mapping_size(size));
+    } catch (std::runtime_error &) {
+      shm_unlink(name.c_str());
+      throw;
+    }
+
+    new(header) Header(size);
+    for (uint32_t i = 0; i < size; ++i) {
+      new(&buffer[i].sequence) std::atomic<uint64_t>(i);
+    }
+    MASK = size - 1;
+
+    // Publish: attachers check the magic number before anything else
+    header->magic.store(MAGIC, std::memory_order_release);
+  };
+
+  /// Attaches to a shared buffer another process created
+  ///
+  /// \param name the shared memory name, starting with '/'
+  explicit SharedRingBuffer(const std::string &name) : name(name), owner(false) {
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd == -1) throw std::runtime_error("No shared ring buffer named " + name);
+
+    struct stat info = {};
+    if (fstat(fd, &info) == -1 || static_cast<size_t>(info.st_size) < sizeof(Header)) {
+      close(fd);
+      throw std::runtime_error("Shared ring buffer is not ready: " + name);
+    }
+    map(fd, static_cast<size_t>(info.st_size));
+
+    // Check the header before trusting anything else in the mapping
+    const char *error = nullptr;
+    if (header->magic.load(std::memory_order_acquire) != MAGIC) error = "is not ready";
+    else if (header->version != VERSION) error = "has a different version";
+    else if (header->itemSize != sizeof(T)) error = "holds a different item type";
+    else if (mappedSize != mapping_size(header->bufferSize)) error = "has the wrong size";
+
+    if (error) {
+      munmap(header, mappedSize);
+      throw std::runtime_error("Shared ring buffer " + name + " " + error);
+    }
+
+    MASK = header->bufferSize - 1;
+    header->attached.fetch_add(1);
+  };
+
+  SharedRingBuffer(const SharedRingBuffer &) = delete;
+  SharedRingBuffer &operator=(const SharedRingBuffer &) = delete;
+
+  /// Detaches. The creator also removes the name, but processes still
+  /// attached keep working until they detach.
+  ~SharedRingBuffer() {
+    detach();
+  }
+
+  /// Unmaps the buffer from this process. Safe to call more than once.
+  void detach() {
+    if (!header) return;
+
+    header->attached.fetch_sub(1);
+    munmap(header, mappedSize);
+    header = nullptr;
+    buffer = nullptr;
+
+    if (owner) shm_unlink(name.c_str());
+  }
+
+  /// Returns the number of processes attached, including this one
+  uint32_t attached() const {
+    return header->attached.load();
+  }
+
+  /// Inserts an item into the buffer.
+  /// Waits until there is room in the buffer.
+  void enqueue_sync(const T &item) {
+    header->notFull.wait([&]() { return push(item); });
+    header->notEmpty.notify();
+  }
+
+  /// Removes an item from the buffer.
+  /// Waits until there is an item in the buffer.
+  ///
+  /// \return the earliest item in the buffer
+  T dequeue_sync() {
+    T result;
+    header->notEmpty.wait([&]() { return pop(result); });
+    header->notFull.notify();
+    return result;
+  }
+
+  /// Inserts an item if there is room, without waiting
+  ///
+  /// \return false if the buffer is full
+  bool try_enqueue(const T &item) {
+    if (!push(item)) return false;
+    header->notEmpty.notify();
+    return true;
+  }
+
+  /// Removes an item if there is one, without waiting
+  ///
+  /// \return false if the buffer is empty
+  bool try_dequeue(T &item) {
+    if (!pop(item)) return false;
+    header->notFull.notify();
+    return true;
+  }
+
+  /// Inserts an item, waiting at most timeout for room in the buffer
+  ///
+  /// \return false if the buffer stayed full
+  template<typename Rep, typename Period>
+  bool enqueue_for(const T &item, const std::chrono::duration<Rep, Period> &timeout) {
+    WaitClock::time_point deadline = WaitClock::now() + timeout;
+    if (!header->notFull.wait_until([&]() { return push(item); }, deadline)) return false;
+    header->notEmpty.notify();
+    return true;
+  }
+
+  /// Removes an item, waiting at most timeout for one to arrive
+  ///
+  /// \return false if the buffer stayed empty
+  template<typename Rep, typename Period>
+  bool dequeue_for(T &item, const std::chrono::duration<Rep, Period> &timeout) {
+    WaitClock::time_point deadline = WaitClock::now() + timeout;
+    if (!header->notEmpty.wait_until([&]() { return pop(item); }, deadline)) return false;
+    header->notFull.notify();
+    return true;
+  }
+};
+
+#endif //CSCI411_SHAREDRINGBUFFER_H
@@ -0,0 +1,326 @@
+//
+// Created by Peter on 10/17/2026.
+//
+
+#ifndef CSCI411_SPILLRINGBUFFER_H
+#define CSCI411_SPILLRINGBUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "RingBuffer.h"
+#include "SpscRingBuffer.h"
+
+/// When a SpillJournal forces spilled items to disk
+enum FsyncPolicy {
+  FSYNC_NONE,   ///< Leave write-back to the kernel
+  FSYNC_CHUNK,  ///< Sync each chunk once it is full
+  FSYNC_BATCH   ///< Sync every syncEvery items
+};
+
+/// Where and how a SpillRingBuffer spills
+struct SpillOptions {
+  std::string path;                ///< The journal file, created or truncated
+  size_t chunkBytes = 1 << 20;     ///< The journal is mapped one chunk at a time
+  FsyncPolicy fsync = FSYNC_NONE;
+  size_t syncEvery = 1024;         ///< Items between syncs with FSYNC_BATCH
+  bool removeOnClose = true;       ///< Delete the file when the buffer goes away
+
+  explicit SpillOptions(const std::string &path) : path(path) {};
+};
+
+/// Append-only FIFO of fixed-size records in a memory-mapped file.
+/// Records are written and read sequentially, one mapped chunk at a time;
+/// chunks that have been read are punched out of the file, and rewind()
+/// truncates it once the journal empties, so disk use follows the items
+/// still waiting. One thread may append while another takes, each side
+/// with its own chunk; SpillRingBuffer locks each side separately.
+///
+/// \tparam T the record type, must be trivially copyable
+template<typename T>
+class SpillJournal {
+  static_assert(std::is_trivially_copyable<T>::value, "Spilled items must be trivially copyable");
+
+ private:
+  const SpillOptions options;
+  const size_t CHUNK_BYTES, PER_CHUNK;
+  int fd;
+
+  uint64_t writeChunk = 0, readChunk = 0;
+  size_t writeSlot = 0, readSlot = 0, syncedSlot = 0;
+  char *writeMap = nullptr, *readMap = nullptr;
+
+  // Written only by the appending side and the taking side; a record is
+  // published to the taker by the store to appended
+  std::atomic<uint64_t> appended, taken;
+
+  /// Rounds the chunk size up to whole pages that hold at least one record
+  static size_t chunk_bytes(size_t requested) {
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t bytes = std::max(requested, sizeof(T));
+    return (bytes + page - 1) / page * page;
+  }
+
+  char *map_chunk(uint64_t chunk) {
+    void *address = mmap(nullptr, CHUNK_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                         static_cast<off_t>(chunk * CHUNK_BYTES));
+    if (address == MAP_FAILED) throw std::runtime_error("Could not map spill journal: " + options.path);
+    return static_cast<char *>(address);
+  }
+
+  /// Forces the records written since the last sync in the write chunk to disk
+  void sync_written() {
+    if (!writeMap || writeSlot == syncedSlot) return;
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t start = syncedSlot * sizeof(T) / page * page;
+    msync(writeMap + start, writeSlot * sizeof(T) - start, MS_SYNC);
+    syncedSlot = writeSlot;
+  }
+
+  /// Finishes the full write chunk and maps the next one
+  void next_write_chunk() {
+    if (writeMap) {
+      if (options.fsync != FSYNC_NONE) sync_written();
+      munmap(writeMap, CHUNK_BYTES);
+      writeMap = nullptr;
+      writeChunk++;
+    }
+
+    if (ftruncate(fd, static_cast<off_t>((writeChunk + 1) * CHUNK_BYTES)) == -1) {
+      throw std::runtime_error("Could not grow spill journal: " + options.path);
+    }
+    writeMap = map_chunk(writeChunk);
+    writeSlot = syncedSlot = 0;
+  }
+
+  /// Drops the fully read chunk from the file and maps the next one
+  void next_read_chunk() {
+    if (readMap) {
+      munmap(readMap, CHUNK_BYTES);
+      readMap = nullptr;
+      fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                static_cast<off_t>(readChunk * CHUNK_BYTES), static_cast<off_t>(CHUNK_BYTES));
+      readChunk++;
+    }
+    readMap = map_chunk(readChunk);
+    readSlot = 0;
+  }
+
+ public:
+  explicit SpillJournal(const SpillOptions &options)
+      : options(options), CHUNK_BYTES(chunk_bytes(options.chunkBytes)), PER_CHUNK(CHUNK_BYTES / sizeof(T)),
+        appended(0), taken(0) {
+    fd = open(options.path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd == -1) throw std::runtime_error("Could not open spill journal: " + options.path);
+  };
+
+  SpillJournal(const SpillJournal &) = delete;
+  SpillJournal &operator=(const SpillJournal &) = delete;
+
+  ~SpillJournal() {
+    if (writeMap) munmap(writeMap, CHUNK_BYTES);
+    if (readMap) munmap(readMap, CHUNK_BYTES);
+    close(fd);
+    if (options.removeOnClose) unlink(options.path.c_str());
+  }
+
+  /// Appends a record to the end of the journal
+  void append(const T &item) {
+    if (!writeMap || writeSlot == PER_CHUNK) next_write_chunk();
+    memcpy(writeMap + writeSlot * sizeof(T), &item, sizeof(T));
+    writeSlot++;
+    appended.store(appended.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+    if (options.fsync == FSYNC_BATCH && writeSlot - syncedSlot >= options.syncEvery) sync_written();
+  }
+
+  /// Reads and removes the oldest record
+  ///
+  /// \return false if the journal is empty
+  bool take(T &item) {
+    uint64_t next = taken.load(std::memory_order_relaxed);
+    if (next == appended.load(std::memory_order_acquire)) return false;
+    if (!readMap || readSlot == PER_CHUNK) next_read_chunk();
+    memcpy(&item, readMap + readSlot * sizeof(T), sizeof(T));
+    readSlot++;
+    taken.store(next + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Starts over at the beginning of an empty file. Neither side may be
+  /// appending or taking meanwhile.
+  void rewind() {
+    if (writeMap) munmap(writeMap, CHUNK_BYTES);
+    if (readMap) munmap(readMap, CHUNK_BYTES);
+    writeMap = readMap = nullptr;
+    writeChunk = readChunk = 0;
+    writeSlot = readSlot = syncedSlot = 0;
+    appended = taken = 0;
+    if (ftruncate(fd, 0) == -1) throw std::runtime_error("Could not truncate spill journal: " + options.path);
+  }
+
+  /// Returns the number of records in the journal
+  uint64_t size() const {
+    // Taken first, so a record appended meanwhile cannot make it negative
+    uint64_t done = taken.load(std::memory_order_acquire);
+    return appended.load(std::memory_order_acquire) - done;
+  }
+};
+
+/// Bounded FIFO queue that spills to disk instead of blocking producers.
+/// Items go into an in-memory ring while it has room. Once it is full,
+/// they are appended to a SpillJournal, and keep going there until the
+/// journal has drained, so the order is kept. Whenever the ring runs dry,
+/// a consumer refills it with the journal's oldest items. RAM use stays at
+/// the ring plus two mapped chunks however long consumers fall behind.
+///
+/// Producers and consumers take separate locks. A consumer reads the
+/// journal back into a batch holding only its own lock, and takes the
+/// producers' lock just to move the batch into the ring, so producers
+/// never wait on the disk.
+///
+/// \tparam T the item type, must be trivially copyable
+/// \tparam Wait what consumers do while the buffer is empty
+template<typename T, typename Wait = BlockingWait>
+class SpillRingBuffer {
+ private:
+  // Each lock serializes one side, so the Spsc core needs no more:
+  // producers insert and append under tailMutex, consumers pop and take
+  // under headMutex
+  alignas(CACHE_LINE_SIZE) std::mutex tailMutex;
+  alignas(CACHE_LINE_SIZE) std::mutex headMutex;
+  RingCore<T, Spsc> ring;
+  SpillJournal<T> journal;
+  std::vector<T> refillBatch;  // Guarded by headMutex
+
+  // Spilled items not yet back in the ring, counting a refill batch in
+  // flight. Producers spill while it is above zero, so the order is kept.
+  // Changed under tailMutex.
+  std::atomic<uint64_t> backlog;
+  std::atomic<uint64_t> spilledTotal;
+  Wait notEmpty;
+
+  /// Inserts into the ring, or spills if the ring is full or older items
+  /// are still spilled. Holds tailMutex.
+  void insert(const T &item) {
+    if (backlog.load(std::memory_order_relaxed) == 0 && ring.emplace(item)) return;
+    journal.append(item);
+    backlog.fetch_add(1, std::memory_order_release);
+    spilledTotal.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /// Reads the oldest spilled items into a batch, without blocking
+  /// producers, then moves the batch into the empty ring. Holds headMutex.
+  void refill() {
+    // Producers leave the ring alone while anything is spilled, so all of it is free
+    size_t n = 0;
+    while (n < refillBatch.size() && journal.take(refillBatch[n])) n++;
+
+    std::lock_guard<std::mutex> lock(tailMutex);
+    for (size_t i = 0; i < n; ++i) ring.emplace(refillBatch[i]);
+    if (backlog.fetch_sub(n, std::memory_order_relaxed) == n) journal.rewind();
+  }
+
+  /// Removes the oldest item, first refilling the ring from the journal if
+  /// it ran dry
+  ///
+  /// \return false if both are empty
+  bool remove(T &item) {
+    std::lock_guard<std::mutex> lock(headMutex);
+    if (ring.pop(item)) return true;
+    if (backlog.load(std::memory_order_acquire) == 0) return false;
+
+    refill();
+    return ring.pop(item);
+  }
+
+ public:
+  /// Creates the ring and an empty journal file
+  ///
+  /// \param bufferSize the number of items kept in memory, rounded up to a power of two
+  /// \param options where the journal goes and how it syncs
+  SpillRingBuffer(unsigned int bufferSize, const SpillOptions &options)
+      : ring(bufferSize), journal(options), backlog(0), spilledTotal(0) {
+    refillBatch.resize(ring.capacity());
+  };
+
+  /// Inserts an item, spilling it to disk if the ring is full. Never waits.
+  ///
+  /// \throws std::runtime_error if the journal cannot be written
+  void enqueue_sync(const T &item) {
+    {
+      std::lock_guard<std::mutex> lock(tailMutex);
+      insert(item);
+    }
+    notEmpty.notify();
+  }
+
+  /// Same as enqueue_sync, for code written against RingBuffer
+  ///
+  /// \return always true
+  bool try_enqueue(const T &item) {
+    enqueue_sync(item);
+    return true;
+  }
+
+  /// Inserts a range of items under one lock, spilling the ones that do not fit
+  template<typename ForwardIt>
+  void enqueue_bulk(ForwardIt first, ForwardIt last) {
+    {
+      std::lock_guard<std::mutex> lock(tailMutex);
+      for (; first != last; ++first) insert(*first);
+    }
+    notEmpty.notify();
+  }
+
+  /// Removes the oldest item, whether in memory or spilled.
+  /// Waits until there is an item.
+  T dequeue_sync() {
+    T result;
+    notEmpty.wait([&]() { return remove(result); });
+    return result;
+  }
+
+  /// Removes the oldest item if there is one, without waiting
+  ///
+  /// \return false if the buffer is empty
+  bool try_dequeue(T &item) {
+    return remove(item);
+  }
+
+  /// Removes the oldest item, waiting at most timeout for one
+  ///
+  /// \return false if the buffer stayed empty
+  template<typename Rep, typename Period>
+  bool dequeue_for(T &item, const std::chrono::duration<Rep, Period> &timeout) {
+    return notEmpty.wait_until([&]() { return remove(item); }, WaitClock::now() + timeout);
+  }
+
+  /// Returns the number of items waiting, in memory and on disk; only a
+  /// hint while other threads are inserting or removing
+  size_t size() {
+    return ring.size() + static_cast<size_t>(backlog.load(std::memory_order_relaxed));
+  }
+
+  /// Returns the number of items waiting on disk
+  uint64_t spilled() {
+    return journal.size();
+  }
+
+  /// Returns the number of items that have ever been spilled
+  uint64_t spilled_total() {
+    return spilledTotal.load(std::memory_order_relaxed);
+  }
+};
+
+#endif //CSCI411_SPILLRINGBUFFER_H
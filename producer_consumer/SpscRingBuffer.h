@@ -0,0 +1,153 @@
+//
+// Created by Peter on 10/17/2026.
+//
+
+#ifndef CSCI411_SPSCRINGBUFFER_H
+#define CSCI411_SPSCRINGBUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <utility>
+#include "RingBuffer.h"
+
+/// Single-producer/single-consumer ring, used by RingBuffer<T, Spsc>.
+/// Only one thread may enqueue and only one thread may dequeue. The fast path
+/// takes no locks and makes no system calls.
+template<typename T, typename Stats>
+class RingCore<T, Spsc, Stats> {
+ private:
+  const size_t BUFFER_SIZE, MASK;
+  T *buffer;
+
+  // Consumer side: next index to remove and the last producer index it saw
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> removeIdx;
+  size_t cachedInsertIdx = 0;
+
+  // Producer side: next index to insert and the last consumer index it saw
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> insertIdx;
+  size_t cachedRemoveIdx = 0;
+
+ public:
+  /// Creates a ring with room for at least the specified size.
+  /// The size is rounded up to the next power of two.
+  explicit RingCore(unsigned int bufferSize)
+      : BUFFER_SIZE(next_power_of_two(bufferSize)),
+        MASK(BUFFER_SIZE - 1),
+        buffer(allocate_items<T>(BUFFER_SIZE)),
+        removeIdx(0),
+        insertIdx(0) {};
+
+  /// Returns the slot storage, so it can be placed on a NUMA node
+  const void *storage() const { return buffer; }
+
+  size_t storage_size() const { return sizeof(T) * BUFFER_SIZE; }
+
+  size_t capacity() const { return BUFFER_SIZE; }
+
+  /// Returns roughly the number of items in the buffer; exact when no thread
+  /// is inserting or removing
+  size_t size() const {
+    size_t removed = removeIdx.load(std::memory_order_relaxed);
+    size_t inserted = insertIdx.load(std::memory_order_relaxed);
+    return std::min(inserted - std::min(inserted, removed), BUFFER_SIZE);
+  }
+
+  /// Lock-free rings have no mutex to contend on
+  uint64_t contentions() const { return 0; }
+
+  ~RingCore() {
+    const size_t end = insertIdx.load(std::memory_order_relaxed);
+    for (size_t idx = removeIdx.load(std::memory_order_relaxed); idx != end; ++idx) {
+      buffer[idx & MASK].~T();
+    }
+    ::operator delete(buffer);
+  }
+
+  /// Constructs an item in place if there is room
+  ///
+  /// \return false if the buffer is full, leaving args untouched
+  template<typename... Args>
+  bool emplace(Args &&... args) {
+    const size_t idx = insertIdx.load(std::memory_order_relaxed);
+
+    // Only reload the consumer's index when the cached one says we are full
+    if (idx - cachedRemoveIdx == BUFFER_SIZE) {
+      cachedRemoveIdx = removeIdx.load(std::memory_order_acquire);
+      if (idx - cachedRemoveIdx == BUFFER_SIZE) return false;
+    }
+
+    new(buffer + (idx & MASK)) T(std::forward<Args>(args)...);
+    insertIdx.store(idx + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Moves an item out if there is one
+  ///
+  /// \return false if the buffer is empty
+  bool pop(T &item) {
+    const size_t idx = removeIdx.load(std::memory_order_relaxed);
+
+    // Only reload the producer's index when the cached one says we are empty
+    if (idx == cachedInsertIdx) {
+      cachedInsertIdx = insertIdx.load(std::memory_order_acquire);
+      if (idx == cachedInsertIdx) return false;
+    }
+
+    item = std::move(buffer[idx & MASK]);
+    buffer[idx & MASK].~T();
+    removeIdx.store(idx + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Inserts up to count items from first in one publish
+  ///
+  /// \return the number of items inserted, 0 if the buffer is full
+  template<typename ForwardIt>
+  size_t push_bulk(ForwardIt &first, size_t count) {
+    const size_t idx = insertIdx.load(std::memory_order_relaxed);
+
+    if (BUFFER_SIZE - (idx - cachedRemoveIdx) < count) {
+      cachedRemoveIdx = removeIdx.load(std::memory_order_acquire);
+    }
+    count = std::min(count, BUFFER_SIZE - (idx - cachedRemoveIdx));
+    if (count == 0) return 0;
+
+    // Copy in at most two spans: up to the end of the buffer, then from the start
+    size_t start = idx & MASK;
+    size_t span = std::min(count, BUFFER_SIZE - start);
+    std::uninitialized_copy_n(first, span, buffer + start);
+    std::advance(first, span);
+    std::uninitialized_copy_n(first, count - span, buffer);
+    std::advance(first, count - span);
+
+    insertIdx.store(idx + count, std::memory_order_release);
+    return count;
+  }
+
+  /// Moves up to max items out into out in one publish
+  ///
+  /// \return the number of items removed, 0 if the buffer is empty
+  template<typename OutputIt>
+  size_t pop_bulk(OutputIt out, size_t max) {
+    const size_t idx = removeIdx.load(std::memory_order_relaxed);
+
+    if (cachedInsertIdx - idx < max) {
+      cachedInsertIdx = insertIdx.load(std::memory_order_acquire);
+    }
+    size_t count = std::min(max, cachedInsertIdx - idx);
+    if (count == 0) return 0;
+
+    size_t start = idx & MASK;
+    size_t span = std::min(count, BUFFER_SIZE - start);
+    out = move_out(buffer + start, span, out);
+    move_out(buffer, count - span, out);
+
+    removeIdx.store(idx + count, std::memory_order_release);
+    return count;
+  }
+};
+
+#endif //CSCI411_SPSCRINGBUFFER_H
@@ -0,0 +1,192 @@
+//
+// Created by Peter on 10/17/2026.
+//
+
+#ifndef CSCI411_THREADPLACEMENT_H
+#define CSCI411_THREADPLACEMENT_H
+
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/// Parses a Linux CPU or node list such as "0-3,8,10-11"
+inline std::vector<int> parse_cpu_list(const std::string &list) {
+  std::vector<int> result;
+  std::stringstream stream(list);
+  std::string range;
+
+  while (std::getline(stream, range, ',')) {
+    if (range.empty() || range == "\n") continue;
+    size_t dash = range.find('-');
+    int first = std::stoi(range.substr(0, dash));
+    int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+    for (int cpu = first; cpu <= last; ++cpu) result.push_back(cpu);
+  }
+  return result;
+}
+
+/// Pins the calling thread to one CPU
+///
+/// \param cpu the CPU, or negative to leave the thread unpinned
+/// \return false if the kernel refused
+inline bool pin_current_thread(int cpu) {
+  if (cpu < 0) return true;
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+/// Asks the kernel to keep a range of memory on a NUMA node, moving pages
+/// already touched elsewhere. Only whole pages inside the range are bound,
+/// so neighbouring heap objects are left alone.
+///
+/// \param node the node, or negative to leave the memory where it is
+inline void bind_to_node(const void *address, size_t size, int node) {
+  if (node < 0 || node >= 64) return;
+
+  uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  uintptr_t start = (reinterpret_cast<uintptr_t>(address) + page - 1) & ~(page - 1);
+  uintptr_t end = (reinterpret_cast<uintptr_t>(address) + size) & ~(page - 1);
+  if (end <= start) return;
+
+  unsigned long mask = 1UL << node;
+  syscall(SYS_mbind, start, end - start, MPOL_PREFERRED, &mask, sizeof(mask) * 8, MPOL_MF_MOVE);
+}
+
+/// Decides which CPU each producer and consumer thread runs on.
+///
+/// Threads are numbered producers first, then consumers, and modes are:
+///   NONE     - leave placement to the scheduler
+///   COMPACT  - fill the CPUs of one node before moving to the next
+///   SCATTER  - deal threads out to the nodes in turn
+///   EXPLICIT - take CPUs from a given list in order
+///   PAIRED   - producer i and consumer i share a node, on neighbouring CPUs
+///
+/// Every mode wraps around when there are more threads than CPUs, and only
+/// uses CPUs this process is allowed to run on.
+class ThreadPlacement {
+ public:
+  enum Mode { NONE, COMPACT, SCATTER, EXPLICIT, PAIRED };
+
+ private:
+  Mode mode;
+  std::vector<int> cpus;               // The explicit list
+  std::vector<std::vector<int>> nodes; // Usable CPUs of every node with any
+  std::vector<int> nodeIds;
+
+  /// Reads the NUMA layout from sysfs. Without it, every usable CPU is on node 0.
+  void discover() {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    sched_getaffinity(0, sizeof(allowed), &allowed);
+
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string line;
+    if (std::getline(online, line)) {
+      for (int node : parse_cpu_list(line)) {
+        std::ifstream cpuList("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string list;
+        std::getline(cpuList, list);
+
+        std::vector<int> usable;
+        for (int cpu : parse_cpu_list(list)) {
+          if (CPU_ISSET(cpu, &allowed)) usable.push_back(cpu);
+        }
+        if (!usable.empty()) {
+          nodes.push_back(usable);
+          nodeIds.push_back(node);
+        }
+      }
+    }
+
+    if (nodes.empty()) {
+      std::vector<int> usable;
+      for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &allowed)) usable.push_back(cpu);
+      }
+      nodes.push_back(usable);
+      nodeIds.push_back(0);
+    }
+  }
+
+  /// Returns the CPU for the k-th thread
+  int cpu_for(size_t k) const {
+    switch (mode) {
+      case COMPACT: {
+        size_t total = 0;
+        for (const std::vector<int> &node : nodes) total += node.size();
+        k %= total;
+        for (const std::vector<int> &node : nodes) {
+          if (k < node.size()) return node[k];
+          k -= node.size();
+        }
+        return -1;
+      }
+      case SCATTER: {
+        const std::vector<int> &node = nodes[k % nodes.size()];
+        return node[(k / nodes.size()) % node.size()];
+      }
+      case EXPLICIT:return cpus.empty() ? -1 : cpus[k % cpus.size()];
+      default:return -1;
+    }
+  }
+
+  /// Returns the CPU for one side of a producer/consumer pair
+  int paired_cpu(size_t pair, size_t side) const {
+    const std::vector<int> &node = nodes[pair % nodes.size()];
+    return node[((pair / nodes.size()) * 2 + side) % node.size()];
+  }
+
+ public:
+  /// Creates a placement by mode; use the list constructor for EXPLICIT
+  explicit ThreadPlacement(Mode mode = NONE) : mode(mode) {
+    discover();
+  };
+
+  /// Creates an EXPLICIT placement from a list of CPUs
+  explicit ThreadPlacement(const std::vector<int> &cpus) : mode(EXPLICIT), cpus(cpus) {
+    discover();
+  };
+
+  Mode get_mode() const { return mode; }
+
+  /// Returns the number of NUMA nodes with usable CPUs
+  size_t num_nodes() const {
+    return nodes.size();
+  }
+
+  /// Returns the CPU for a producer, or -1 if it is not pinned
+  int producer_cpu(size_t producer_id) const {
+    if (mode == PAIRED) return paired_cpu(producer_id, 0);
+    return cpu_for(producer_id);
+  }
+
+  /// Returns the CPU for a consumer, or -1 if it is not pinned
+  ///
+  /// \param numProducers the number of producers, numbered before the consumers
+  int consumer_cpu(size_t consumer_id, size_t numProducers) const {
+    if (mode == PAIRED) return paired_cpu(consumer_id, 1);
+    return cpu_for(numProducers + consumer_id);
+  }
+
+  /// Returns the NUMA node a CPU belongs to, or -1 if unknown
+  int node_of(int cpu) const {
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      for (int nodeCpu : nodes[i]) {
+        if (nodeCpu == cpu) return nodeIds[i];
+      }
+    }
+    return -1;
+  }
+};
+
+#endif //CSCI411_THREADPLACEMENT_H
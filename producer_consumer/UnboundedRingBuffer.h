@@ -0,0 +1,255 @@
+//
+// Created by Peter on 10/17/2026.
+//
+
+#ifndef CSCI411_UNBOUNDEDRINGBUFFER_H
+#define CSCI411_UNBOUNDEDRINGBUFFER_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+#include "RingBuffer.h"
+
+/// Unbounded queue of linked fixed-size segments, used by RingBuffer<T, Unbounded>.
+/// Inserting never fails, so producers never block; the queue grows a
+/// segment at a time instead. Producers and consumers take separate locks
+/// and only meet on the item count, so they do not contend with each other.
+///
+/// Emptied segments are kept for reuse, up to SPARE_SEGMENTS of them, so
+/// steady state does no allocation while memory stays close to the live
+/// items plus one segment.
+template<typename T, typename Stats>
+class RingCore<T, Unbounded, Stats> {
+ private:
+  static const size_t SPARE_SEGMENTS = 1;
+
+  struct Segment {
+    T *items;
+    Segment *next = nullptr;
+
+    explicit Segment(size_t size) : items(allocate_items<T>(size)) {};
+
+    ~Segment() {
+      ::operator delete(items);
+    }
+  };
+
+  const size_t SEGMENT_SIZE;
+
+  // Consumer side: the segment being read and the next index in it
+  alignas(CACHE_LINE_SIZE) std::mutex headMutex;
+  Segment *head;
+  size_t readIdx = 0;
+  LockCounter<Stats::ENABLED> headContended;
+
+  // Producer side: the segment being written and the next index in it
+  alignas(CACHE_LINE_SIZE) std::mutex tailMutex;
+  Segment *tail;
+  size_t writeIdx = 0;
+  LockCounter<Stats::ENABLED> tailContended;
+
+  // Items inserted and not yet removed; inserts publish through it
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> count;
+
+  std::mutex poolMutex;
+  std::vector<Segment *> pool;
+
+  size_t highWater = 0;
+  std::function<void(size_t)> onHighWater;
+
+  /// Takes a segment from the pool, or allocates one if the pool is empty
+  Segment *take_segment() {
+    {
+      std::lock_guard<std::mutex> lock(poolMutex);
+      if (!pool.empty()) {
+        Segment *segment = pool.back();
+        pool.pop_back();
+        segment->next = nullptr;
+        return segment;
+      }
+    }
+    return new Segment(SEGMENT_SIZE);
+  }
+
+  /// Returns an emptied segment to the pool, or frees it if the pool is full
+  void recycle(Segment *segment) {
+    {
+      std::lock_guard<std::mutex> lock(poolMutex);
+      if (pool.size() < SPARE_SEGMENTS) {
+        pool.push_back(segment);
+        return;
+      }
+    }
+    delete segment;
+  }
+
+  /// Makes room for one more item at the tail. Holds tailMutex.
+  void reserve_one() {
+    if (writeIdx < SEGMENT_SIZE) return;
+    Segment *segment = take_segment();
+    tail->next = segment;
+    tail = segment;
+    writeIdx = 0;
+  }
+
+  /// Moves past an emptied head segment. Holds headMutex.
+  void advance_head() {
+    if (readIdx < SEGMENT_SIZE) return;
+    Segment *emptied = head;
+    head = head->next;
+    readIdx = 0;
+    recycle(emptied);
+  }
+
+  /// Publishes n inserted items and fires the high-water callback on the way up.
+  /// Every change to count is one atomic step, so exactly one insert sees
+  /// each crossing from below the mark to at or above it, and a removal
+  /// that drops below the mark re-arms the callback just by doing so.
+  void published(size_t n) {
+    size_t before = count.fetch_add(n, std::memory_order_release);
+    if (highWater != 0 && before < highWater && before + n >= highWater && onHighWater) {
+      onHighWater(before + n);
+    }
+  }
+
+  /// Accounts for n removed items.
+  /// Holds headMutex, so the next consumer never counts items already taken.
+  void removed(size_t n) {
+    count.fetch_sub(n, std::memory_order_release);
+  }
+
+ public:
+  /// Creates an empty queue
+  ///
+  /// \param segmentSize the number of items in each segment
+  explicit RingCore(unsigned int segmentSize)
+      : SEGMENT_SIZE(std::max(segmentSize, 1u)), count(0) {
+    head = tail = new Segment(SEGMENT_SIZE);
+  };
+
+  ~RingCore() {
+    // Destroy the items still queued, which may span several segments
+    size_t left = count.load();
+    while (left > 0) {
+      advance_head();
+      head->items[readIdx++].~T();
+      left--;
+    }
+
+    while (head) {
+      Segment *next = head->next;
+      delete head;
+      head = next;
+    }
+    for (Segment *segment : pool) delete segment;
+  }
+
+  /// Calls a callback when the number of items reaches a mark. It fires
+  /// once per crossing and re-arms when the queue drops below the mark.
+  /// Callbacks for crossings close together may run at the same time on
+  /// different inserting threads. Set it before any thread uses the queue.
+  ///
+  /// \param mark the number of items, 0 to turn the callback off
+  /// \param callback called by the inserting thread with the current size
+  void set_high_water(size_t mark, const std::function<void(size_t)> &callback) {
+    highWater = mark;
+    onHighWater = callback;
+  }
+
+  /// Unbounded queues have no fixed slot storage to place on a NUMA node
+  const void *storage() const { return nullptr; }
+
+  size_t storage_size() const { return 0; }
+
+  /// Returns the high-water mark if one is set, otherwise the largest size_t,
+  /// so occupancy reads relative to the mark
+  size_t capacity() const {
+    return highWater != 0 ? highWater : std::numeric_limits<size_t>::max();
+  }
+
+  size_t size() const {
+    return count.load(std::memory_order_relaxed);
+  }
+
+  /// Returns the number of lock acquisitions that had to wait for another thread
+  uint64_t contentions() {
+    return headContended.contentions(headMutex) + tailContended.contentions(tailMutex);
+  }
+
+  /// Constructs an item in place at the tail, adding a segment if needed
+  ///
+  /// \return always true
+  template<typename... Args>
+  bool emplace(Args &&... args) {
+    {
+      std::unique_lock<std::mutex> lock = tailContended.acquire(tailMutex);
+      reserve_one();
+      new(tail->items + writeIdx) T(std::forward<Args>(args)...);
+      writeIdx++;
+    }
+    published(1);
+    return true;
+  }
+
+  /// Moves the head item out if there is one
+  ///
+  /// \return false if the queue is empty
+  bool pop(T &item) {
+    {
+      std::unique_lock<std::mutex> lock = headContended.acquire(headMutex);
+      if (count.load(std::memory_order_acquire) == 0) return false;
+
+      advance_head();
+      item = std::move(head->items[readIdx]);
+      head->items[readIdx].~T();
+      readIdx++;
+      removed(1);
+    }
+    return true;
+  }
+
+  /// Inserts all n items, adding segments as needed
+  ///
+  /// \return n
+  template<typename ForwardIt>
+  size_t push_bulk(ForwardIt &first, size_t n) {
+    {
+      std::unique_lock<std::mutex> lock = tailContended.acquire(tailMutex);
+      for (size_t i = 0; i < n; ++i, ++first) {
+        reserve_one();
+        new(tail->items + writeIdx) T(*first);
+        writeIdx++;
+      }
+    }
+    if (n > 0) published(n);
+    return n;
+  }
+
+  /// Moves up to max items out into out
+  ///
+  /// \return the number of items removed, 0 if the queue is empty
+  template<typename OutputIt>
+  size_t pop_bulk(OutputIt out, size_t max) {
+    size_t n;
+    {
+      std::unique_lock<std::mutex> lock = headContended.acquire(headMutex);
+      n = std::min(max, count.load(std::memory_order_acquire));
+      for (size_t i = 0; i < n; ++i) {
+        advance_head();
+        *out++ = std::move(head->items[readIdx]);
+        head->items[readIdx].~T();
+        readIdx++;
+      }
+      if (n > 0) removed(n);
+    }
+    return n;
+  }
+};
+
+#endif //CSCI411_UNBOUNDEDRINGBUFFER_H
@@ -0,0 +1,248 @@
+//
+// Created by Peter on 10/17/2026.
+//
+
+#ifndef CSCI411_WAITSTRATEGY_H
+#define CSCI411_WAITSTRATEGY_H
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <ctime>
+#include <linux/futex.h>
+#include <semaphore.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+
+// Wait strategies decide what a thread does while a RingBuffer is full or
+// empty. Each one is an event the blocked side waits on and the other side
+// notifies after every insert or remove:
+//
+//   wait(ready)                 - returns once ready() is true
+//   wait_until(ready, deadline) - same, but gives up at the deadline
+//   notify()                    - wakes threads blocked in wait()
+//
+// ready() is the non-blocking operation itself, so a waiter that wakes up
+// has already done its insert or remove.
+
+typedef std::chrono::steady_clock WaitClock;
+
+/// Size of a cache line, used to keep indices written by different threads apart
+const size_t CACHE_LINE_SIZE = 64;
+
+/// Tells the CPU we are in a spin loop
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  asm volatile("yield");
+#endif
+}
+
+/// Sleeps while *address == expected, for at most timeout (nullptr = forever)
+///
+/// \param shared if the word may be shared between processes
+inline void futex_wait(std::atomic<uint32_t> *address, uint32_t expected,
+                       const timespec *timeout, bool shared = false) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(address),
+          shared ? FUTEX_WAIT : FUTEX_WAIT_PRIVATE, expected, timeout, nullptr, 0);
+}
+
+/// Wakes up to count threads sleeping on address
+///
+/// \param shared if the word may be shared between processes
+inline void futex_wake(std::atomic<uint32_t> *address, int count = INT_MAX, bool shared = false) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(address),
+          shared ? FUTEX_WAKE : FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
+
+/// Converts the time left until a deadline to a timespec
+///
+/// \return false if the deadline has passed
+inline bool time_left(WaitClock::time_point deadline, timespec &out) {
+  WaitClock::duration left = deadline - WaitClock::now();
+  if (left <= WaitClock::duration::zero()) return false;
+
+  std::chrono::nanoseconds ns = std::chrono::duration_cast<std::chrono::nanoseconds>(left);
+  out.tv_sec = static_cast<time_t>(ns.count() / 1000000000);
+  out.tv_nsec = static_cast<long>(ns.count() % 1000000000);
+  return true;
+}
+
+/// Never sleeps. Lowest latency, but a blocked thread keeps its core busy,
+/// so only use it with a core to spare for every spinning thread.
+class BusySpinWait {
+ public:
+  template<typename Ready>
+  void wait(Ready ready) {
+    while (!ready()) cpu_relax();
+  }
+
+  template<typename Ready>
+  bool wait_until(Ready ready, WaitClock::time_point deadline) {
+    for (unsigned int i = 1; !ready(); ++i) {
+      // Reading the clock costs more than a pause, so only check now and then
+      if (i % 64 == 0 && WaitClock::now() >= deadline) return false;
+      cpu_relax();
+    }
+    return true;
+  }
+
+  void notify() {}
+};
+
+/// Spins for a bounded number of pauses, then parks on a futex.
+/// Hand-offs that complete within the spin window never enter the kernel.
+/// Constructed as shared, it can live in memory mapped by several processes.
+class SpinParkWait {
+ private:
+  static const unsigned int SPIN_LIMIT = 2048;
+
+  std::atomic<uint32_t> epoch;
+  std::atomic<uint32_t> waiters;
+  const bool shared;
+
+  /// Spins until ready or the spin budget runs out.
+  /// On a single CPU the other side cannot run while we spin, so park at once.
+  template<typename Ready>
+  bool spin(Ready &ready) {
+    static const unsigned int limit = std::thread::hardware_concurrency() > 1 ? SPIN_LIMIT : 0;
+    for (unsigned int i = 0; i < limit; ++i) {
+      if (ready()) return true;
+      cpu_relax();
+    }
+    return false;
+  }
+
+ public:
+  explicit SpinParkWait(bool shared = false) : epoch(0), waiters(0), shared(shared) {};
+
+  template<typename Ready>
+  void wait(Ready ready) {
+    if (spin(ready)) return;
+
+    while (true) {
+      // Announce ourselves before the last check so notify() cannot miss us
+      waiters.fetch_add(1);
+      uint32_t seen = epoch.load();
+      if (ready()) {
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+        return;
+      }
+
+      futex_wait(&epoch, seen, nullptr, shared);
+      waiters.fetch_sub(1, std::memory_order_relaxed);
+      if (ready()) return;
+    }
+  }
+
+  template<typename Ready>
+  bool wait_until(Ready ready, WaitClock::time_point deadline) {
+    if (spin(ready)) return true;
+
+    timespec timeout = {};
+    while (time_left(deadline, timeout)) {
+      waiters.fetch_add(1);
+      uint32_t seen = epoch.load();
+      if (ready()) {
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+      }
+
+      futex_wait(&epoch, seen, &timeout, shared);
+      waiters.fetch_sub(1, std::memory_order_relaxed);
+      if (ready()) return true;
+    }
+    return ready();
+  }
+
+  void notify() {
+    // Pairs with the fetch_add in wait(): either the waiter sees our update
+    // in ready(), or we see the waiter here
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters.load(std::memory_order_relaxed) != 0) {
+      epoch.fetch_add(1, std::memory_order_release);
+      futex_wake(&epoch, INT_MAX, shared);
+    }
+  }
+};
+
+/// Sleeps in sem_wait straight away, like the original RingBuffer.
+/// Lowest CPU use; every blocked hand-off pays a kernel sleep and wakeup.
+class BlockingWait {
+ private:
+  sem_t semaphore;
+  std::atomic<uint32_t> waiters;
+
+  /// Takes back a registration, or the token a notify() already posted for it
+  void withdraw() {
+    uint32_t count = waiters.load(std::memory_order_relaxed);
+    while (count > 0 && !waiters.compare_exchange_weak(count, count - 1)) {}
+    if (count == 0) {
+      while (sem_wait(&semaphore) == -1 && errno == EINTR) {}
+    }
+  }
+
+ public:
+  BlockingWait() : waiters(0) {
+    sem_init(&semaphore, 0, 0);
+  };
+
+  ~BlockingWait() {
+    sem_destroy(&semaphore);
+  }
+
+  template<typename Ready>
+  void wait(Ready ready) {
+    while (!ready()) {
+      waiters.fetch_add(1);
+      if (ready()) {
+        withdraw();
+        return;
+      }
+      while (sem_wait(&semaphore) == -1 && errno == EINTR) {}
+    }
+  }
+
+  template<typename Ready>
+  bool wait_until(Ready ready, WaitClock::time_point deadline) {
+    while (!ready()) {
+      waiters.fetch_add(1);
+      if (ready()) {
+        withdraw();
+        return true;
+      }
+
+      // sem_timedwait wants an absolute CLOCK_REALTIME time
+      timespec left = {}, abs_timeout = {};
+      if (!time_left(deadline, left)) {
+        withdraw();
+        return ready();
+      }
+      clock_gettime(CLOCK_REALTIME, &abs_timeout);
+      abs_timeout.tv_sec += left.tv_sec;
+      abs_timeout.tv_nsec += left.tv_nsec;
+      if (abs_timeout.tv_nsec >= 1000000000) {
+        abs_timeout.tv_sec += 1;
+        abs_timeout.tv_nsec -= 1000000000;
+      }
+
+      if (sem_timedwait(&semaphore, &abs_timeout) == -1) withdraw();
+    }
+    return true;
+  }
+
+  void notify() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters.load(std::memory_order_relaxed) != 0) {
+      // One token per registered waiter; they re-check ready() on wakeup
+      uint32_t count = waiters.exchange(0);
+      for (uint32_t i = 0; i < count; ++i) sem_post(&semaphore);
+    }
+  }
+};
+
+#endif //CSCI411_WAITSTRATEGY_H
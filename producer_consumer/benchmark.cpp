@@ -0,0 +1,602 @@
+/*
+ * Peter Nguyen
+ * CSCI 411 - Producer Consumer - Benchmark
+ *
+ * Compile with `-std=c++11 -O2 -pthread`
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+#include "RingBuffer.h"
+#include "SpscRingBuffer.h"
+#include "MpmcRingBuffer.h"
+#include "UnboundedRingBuffer.h"
+#include "ProducerConsumer.h"
+#include "LatencyHistogram.h"
+#include "AsyncLogger.h"
+#include "MulticastRingBuffer.h"
+#include "SpillRingBuffer.h"
+#include "Pipeline.h"
+#include "PriorityRingBuffer.h"
+#include "LoadGenerator.h"
+
+/// 64-byte plain-old-data payload
+struct Pod64 {
+  uint64_t words[8];
+};
+
+/// A payload together with the time it was enqueued
+template<typename Payload>
+struct Stamped {
+  Payload payload;
+  uint64_t stamp;
+};
+
+/// Nanoseconds on the steady clock
+inline uint64_t now_ns() {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/// Builds the n-th payload of each type
+template<typename Payload>
+Payload make_payload(size_t n);
+
+template<>
+short make_payload<short>(size_t n) {
+  return static_cast<short>(n);
+}
+
+template<>
+Pod64 make_payload<Pod64>(size_t n) {
+  Pod64 pod;
+  for (uint64_t &word : pod.words) word = n;
+  return pod;
+}
+
+template<>
+std::string make_payload<std::string>(size_t n) {
+  // Long enough to defeat the small string optimization
+  return "benchmark-payload-" + std::to_string(n) + "-0123456789";
+}
+
+/// Result of one benchmark run
+struct Result {
+  double items_per_second;
+  LatencyHistogram latency;
+};
+
+/// Prints one row of the results table
+void print_row(const std::string &queue, const std::string &driver, const std::string &type,
+               size_t producers, size_t consumers, unsigned int size, const Result &result) {
+  std::cout << std::left << std::setw(18) << queue
+            << std::setw(10) << driver
+            << std::setw(8) << type
+            << std::right << std::setw(3) << producers << ":" << std::left << std::setw(3) << consumers
+            << std::right << std::setw(6) << size
+            << std::setw(14) << std::fixed << std::setprecision(0) << result.items_per_second
+            << std::setw(10) << result.latency.percentile(50)
+            << std::setw(10) << result.latency.percentile(99)
+            << std::setw(10) << result.latency.percentile(99.9)
+            << std::endl;
+}
+
+/// Drives a RingBuffer directly with plain threads
+template<typename Payload, typename Policy, typename Wait>
+Result run_ring(size_t producers, size_t consumers, unsigned int size, size_t items) {
+  typedef Stamped<Payload> Item;
+  RingBuffer<Item, Policy, Wait> ringBuffer(size);
+  std::vector<LatencyHistogram> histograms(consumers);
+  std::vector<std::thread> threads;
+  size_t per_producer = items / producers, total = per_producer * producers;
+
+  uint64_t start = now_ns();
+  for (size_t i = 0; i < producers; ++i) {
+    threads.emplace_back([&]() {
+      for (size_t n = 0; n < per_producer; ++n) {
+        Item item = {make_payload<Payload>(n), now_ns()};
+        ringBuffer.enqueue_sync(item);
+      }
+    });
+  }
+  for (size_t i = 0; i < consumers; ++i) {
+    // Split the items so every consumer knows exactly how many to take
+    size_t share = total / consumers + (i < total % consumers ? 1 : 0);
+    threads.emplace_back([&, i, share]() {
+      for (size_t n = 0; n < share; ++n) {
+        Item item = ringBuffer.dequeue_sync();
+        histograms[i].record(now_ns() - item.stamp);
+      }
+    });
+  }
+  for (std::thread &thread : threads) thread.join();
+  uint64_t elapsed = now_ns() - start;
+
+  Result result;
+  result.items_per_second = total * 1e9 / elapsed;
+  for (const LatencyHistogram &histogram : histograms) result.latency.merge(histogram);
+  return result;
+}
+
+/// Runs a ProducerConsumer system to completion and measures it
+template<typename Item, typename System>
+Result drive(System &producerConsumer, size_t producers, size_t consumers, size_t items) {
+  std::vector<LatencyHistogram> histograms(consumers);
+  size_t per_producer = items / producers;
+
+  uint64_t start = now_ns();
+  producerConsumer.run(
+      per_producer,
+      [](size_t producer_id) {
+        Item item = {make_payload<decltype(Item::payload)>(producer_id), now_ns()};
+        return item;
+      },
+      [&](size_t consumer_id, Item &item) {
+        histograms[consumer_id].record(now_ns() - item.stamp);
+      }
+  );
+  uint64_t elapsed = now_ns() - start;
+
+  Result result;
+  result.items_per_second = per_producer * producers * 1e9 / elapsed;
+  for (const LatencyHistogram &histogram : histograms) result.latency.merge(histogram);
+  return result;
+}
+
+/// Drives a RingBuffer through ProducerConsumer::run
+template<typename Payload, typename Policy, typename Wait>
+Result run_producer_consumer(size_t producers, size_t consumers, unsigned int size, size_t items) {
+  typedef Stamped<Payload> Item;
+  RingBuffer<Item, Policy, Wait> ringBuffer(size);
+  ProducerConsumer<Item, Policy, Wait> producerConsumer(std::ref(ringBuffer), producers, consumers);
+  return drive<Item>(producerConsumer, producers, consumers, items);
+}
+
+/// Drives a ShardedRingBuffer, one shard per producer, through ProducerConsumer::run
+template<typename Payload, typename Policy, typename Wait>
+Result run_sharded(size_t producers, size_t consumers, unsigned int size, size_t items) {
+  typedef Stamped<Payload> Item;
+  typedef ProducerConsumer<Item, Policy, Wait> System;
+  typename System::ShardedBuffer shardedBuffer(producers, size);
+  System producerConsumer(std::ref(shardedBuffer), producers, consumers);
+  return drive<Item>(producerConsumer, producers, consumers, items);
+}
+
+/// Runs ProducerConsumer over a counting ring and prints its counters
+template<typename Payload, typename Policy, typename Wait>
+void report_stats(const std::string &queue, const std::string &type,
+                  size_t producers, size_t consumers, unsigned int size, size_t items) {
+  typedef Stamped<Payload> Item;
+  RingBuffer<Item, Policy, Wait, QueueStats> ringBuffer(size);
+  ProducerConsumer<Item, Policy, Wait, QueueStats> producerConsumer(std::ref(ringBuffer), producers, consumers);
+  print_row(queue, "stats", type, producers, consumers, size,
+            drive<Item>(producerConsumer, producers, consumers, items));
+
+  RingStats stats = ringBuffer.stats();
+  std::cout << "    enqueues " << stats.enqueues << ", blocked " << stats.blockedEnqueues
+            << ", wait total/max " << stats.enqueueWaitNs / 1000 << "/" << stats.maxEnqueueWaitNs / 1000 << " us\n"
+            << "    dequeues " << stats.dequeues << ", blocked " << stats.blockedDequeues
+            << ", wait total/max " << stats.dequeueWaitNs / 1000 << "/" << stats.maxDequeueWaitNs / 1000 << " us\n"
+            << "    contentions " << stats.contentions << ", occupancy (tenths full)";
+  for (uint64_t bucket : stats.occupancy) std::cout << " " << bucket;
+  std::cout << std::endl;
+}
+
+/// Runs ProducerConsumer with one thread placement
+template<typename Payload, typename Policy, typename Wait>
+Result run_placed(const ThreadPlacement &placement, size_t threads, unsigned int size, size_t items) {
+  typedef Stamped<Payload> Item;
+  RingBuffer<Item, Policy, Wait> ringBuffer(size);
+  ProducerConsumer<Item, Policy, Wait> producerConsumer(std::ref(ringBuffer), threads, threads);
+  producerConsumer.set_placement(placement);
+  return drive<Item>(producerConsumer, threads, threads, items);
+}
+
+/// Compares the thread placements
+template<typename Payload, typename Policy, typename Wait>
+void sweep_placement(const std::string &queue, const std::string &type, size_t items) {
+  const ThreadPlacement::Mode modes[] = {ThreadPlacement::NONE, ThreadPlacement::COMPACT,
+                                         ThreadPlacement::SCATTER, ThreadPlacement::PAIRED};
+  const char *names[] = {"pc", "compact", "scatter", "paired"};
+  for (size_t i = 0; i < 4; ++i) {
+    print_row(queue, names[i], type, 2, 2, 1024,
+              run_placed<Payload, Policy, Wait>(ThreadPlacement(modes[i]), 2, 1024, items));
+  }
+}
+
+/// Compares one shared ring against sharded rings as thread counts grow
+template<typename Payload, typename Policy, typename Wait>
+void sweep_scaling(const std::string &queue, const std::string &type, size_t items) {
+  const size_t thread_counts[] = {1, 2, 4, 8, 16, 32};
+  for (size_t threads : thread_counts) {
+    print_row(queue, "pc", type, threads, threads, 1024,
+              run_producer_consumer<Payload, Policy, Wait>(threads, threads, 1024, items));
+    print_row(queue, "sharded", type, threads, threads, 1024,
+              run_sharded<Payload, Policy, Wait>(threads, threads, 1024, items));
+  }
+}
+
+/// Runs one queue type over every thread count and buffer size
+template<typename Payload, typename Policy, typename Wait>
+void sweep(const std::string &queue, const std::string &type, size_t items, bool single_only) {
+  const size_t thread_counts[][2] = {{1, 1}, {2, 2}, {4, 4}, {1, 4}, {4, 1}};
+  const unsigned int sizes[] = {16, 1024};
+
+  for (const size_t *threads : thread_counts) {
+    if (single_only && (threads[0] != 1 || threads[1] != 1)) continue;
+    for (unsigned int size : sizes) {
+      print_row(queue, "ring", type, threads[0], threads[1], size,
+                run_ring<Payload, Policy, Wait>(threads[0], threads[1], size, items));
+      print_row(queue, "pc", type, threads[0], threads[1], size,
+                run_producer_consumer<Payload, Policy, Wait>(threads[0], threads[1], size, items));
+    }
+  }
+}
+
+/// Runs every queue type for one payload type
+template<typename Payload>
+void sweep_queues(const std::string &type, size_t items) {
+  sweep<Payload, Locking, BlockingWait>("locking/blocking", type, items, false);
+  sweep<Payload, Locking, SpinParkWait>("locking/spinpark", type, items, false);
+  sweep<Payload, Mpmc, BlockingWait>("mpmc/blocking", type, items, false);
+  sweep<Payload, Mpmc, SpinParkWait>("mpmc/spinpark", type, items, false);
+  sweep<Payload, Unbounded, BlockingWait>("unbounded/block", type, items, false);
+  sweep<Payload, Spsc, BlockingWait>("spsc/blocking", type, items, true);
+  sweep<Payload, Spsc, SpinParkWait>("spsc/spinpark", type, items, true);
+}
+
+/// Times making items: a fresh std::mt19937 per item, as producers once
+/// did, against the batched xoshiro256** generator
+void time_generation(size_t items) {
+  std::vector<short> out(items);
+  uint64_t start = now_ns();
+  for (size_t n = 0; n < items; ++n) {
+    std::mt19937 generator(static_cast<unsigned int>(n));
+    std::uniform_int_distribution<short> dist(std::numeric_limits<short>::min(), std::numeric_limits<short>::max());
+    out[n] = dist(generator);
+  }
+  double fresh = static_cast<double>(now_ns() - start) / items;
+
+  ItemGenerator<short> generate(42);
+  start = now_ns();
+  for (size_t n = 0; n < items; ++n) out[n] = generate();
+  double single = static_cast<double>(now_ns() - start) / items;
+
+  start = now_ns();
+  generate.fill(out.data(), items);
+  double batched = static_cast<double>(now_ns() - start) / items;
+
+  std::cout << "item generation: mt19937 per item " << std::fixed << std::setprecision(2) << fresh
+            << " ns, xoshiro one at a time " << single << " ns, xoshiro batched " << batched
+            << " ns/item" << std::endl;
+}
+
+/// Measures what an AsyncLogger costs the thread that logs
+void time_logging(LogLevel level, unsigned int sampleEvery, size_t items) {
+  std::ostream sink(nullptr);
+  std::streambuf *saved = std::cout.rdbuf(sink.rdbuf());
+
+  AsyncLogger logger(level, sampleEvery, 65536);
+  AsyncLogger::Channel &channel = logger.channel();
+  logger.start();
+
+  uint64_t start = now_ns();
+  for (size_t n = 0; n < items; ++n) channel.log(LOG_INFO, PRODUCED, 0, static_cast<short>(n));
+  uint64_t elapsed = now_ns() - start;
+
+  logger.stop();
+  std::cout.rdbuf(saved);
+  std::cout << "logging level " << level << " sample 1/" << sampleEvery << ": "
+            << std::fixed << std::setprecision(1) << static_cast<double>(elapsed) / items << " ns/item" << std::endl;
+}
+
+/// Sends every item to three readers: two that read in parallel and one
+/// that runs after both, through one MulticastRingBuffer
+template<typename Payload>
+double run_multicast(size_t items) {
+  MulticastRingBuffer<Payload, BlockingWait> ring(1024);
+  size_t persist = ring.add_group(), aggregate = ring.add_group();
+  size_t forward = ring.add_group({persist, aggregate});
+  const size_t groups[] = {persist, aggregate, forward};
+
+  std::vector<std::thread> threads;
+  uint64_t start = now_ns();
+  threads.emplace_back([&]() {
+    for (size_t n = 0; n < items; ++n) ring.publish(make_payload<Payload>(n));
+  });
+  for (size_t group : groups) {
+    threads.emplace_back([&, group]() {
+      size_t seen = 0, bytes = 0;
+      while (seen < items) {
+        seen += ring.consume(group, [&](const Payload &payload, uint64_t) { bytes += sizeof(payload); });
+      }
+    });
+  }
+  for (std::thread &thread : threads) thread.join();
+  return items * 1e9 / (now_ns() - start);
+}
+
+/// The same three readers, with the producer copying every item into a
+/// queue per reader and the first two readers feeding the third
+template<typename Payload>
+double run_fan_out(size_t items) {
+  RingBuffer<Payload, Spsc, BlockingWait> persist(1024), aggregate(1024), forwardA(1024), forwardB(1024);
+
+  std::vector<std::thread> threads;
+  uint64_t start = now_ns();
+  threads.emplace_back([&]() {
+    for (size_t n = 0; n < items; ++n) {
+      Payload payload = make_payload<Payload>(n);
+      persist.enqueue_sync(payload);
+      aggregate.enqueue_sync(payload);
+    }
+  });
+  threads.emplace_back([&]() {
+    for (size_t n = 0; n < items; ++n) forwardA.enqueue_sync(persist.dequeue_sync());
+  });
+  threads.emplace_back([&]() {
+    for (size_t n = 0; n < items; ++n) forwardB.enqueue_sync(aggregate.dequeue_sync());
+  });
+  threads.emplace_back([&]() {
+    for (size_t n = 0; n < items; ++n) {
+      forwardA.dequeue_sync();
+      forwardB.dequeue_sync();
+    }
+  });
+  for (std::thread &thread : threads) thread.join();
+  return items * 1e9 / (now_ns() - start);
+}
+
+/// Compares multicast against fan-out copies for one payload type
+template<typename Payload>
+void compare_multicast(const std::string &type, size_t items) {
+  std::cout << std::left << std::setw(20) << "multicast 3 groups" << std::setw(8) << type
+            << std::right << std::setw(14) << std::fixed << std::setprecision(0) << run_multicast<Payload>(items)
+            << " items/s, fan-out copies " << run_fan_out<Payload>(items) << " items/s" << std::endl;
+}
+
+/// CPU time this process has used, user and system, in seconds
+double cpu_seconds() {
+  rusage usage = {};
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+/// Runs a bursty load: producers send bursts of items separated by pauses,
+/// and consumers block for a while on every item, as if doing I/O
+template<typename Policy, typename Wait>
+void run_bursty(const std::string &name, const ElasticPolicy &policy, size_t producers, size_t items) {
+  typedef Stamped<short> Item;
+  const size_t burst = 500;
+  const std::chrono::milliseconds pause(20);
+  const std::chrono::microseconds work(20);
+
+  RingBuffer<Item, Policy, Wait> ringBuffer(1024);
+  ProducerConsumer<Item, Policy, Wait> producerConsumer(std::ref(ringBuffer), producers, policy.minWorkers);
+  producerConsumer.set_elastic(policy);
+
+  std::vector<size_t> sent(producers, 0);
+  std::vector<LatencyHistogram> histograms(policy.maxWorkers);
+  size_t per_producer = items / producers;
+
+  double cpu_start = cpu_seconds();
+  uint64_t start = now_ns();
+  producerConsumer.run(
+      per_producer,
+      [&](size_t producer_id) {
+        if (++sent[producer_id] % burst == 0) std::this_thread::sleep_for(pause);
+        Item item = {0, now_ns()};
+        return item;
+      },
+      [&](size_t consumer_id, Item &item) {
+        histograms[consumer_id].record(now_ns() - item.stamp);
+        std::this_thread::sleep_for(work);
+      }
+  );
+  uint64_t elapsed = now_ns() - start;
+  double cpu = cpu_seconds() - cpu_start;
+
+  LatencyHistogram latency;
+  for (const LatencyHistogram &histogram : histograms) latency.merge(histogram);
+  const ElasticPool &pool = *producerConsumer.consumer_pool();
+
+  std::cout << std::left << std::setw(18) << name
+            << std::right << std::setw(12) << std::fixed << std::setprecision(0)
+            << per_producer * producers * 1e9 / elapsed
+            << std::setw(12) << latency.percentile(99) / 1000
+            << std::setw(10) << std::setprecision(3) << cpu
+            << std::setw(10) << std::setprecision(2) << pool.average_size()
+            << std::setw(6) << pool.peak()
+            << std::setw(8) << pool.resizes()
+            << std::endl;
+}
+
+/// Compares fixed consumer pools against an elastic one on a bursty load
+void sweep_bursty(size_t items) {
+  std::cout << std::left << std::setw(18) << "bursty consumers"
+            << std::right << std::setw(12) << "items/s"
+            << std::setw(12) << "p99 us"
+            << std::setw(10) << "cpu s"
+            << std::setw(10) << "avg"
+            << std::setw(6) << "peak"
+            << std::setw(8) << "resizes"
+            << std::endl;
+
+  run_bursty<Mpmc, BlockingWait>("fixed 1", ElasticPolicy::fixed(1), 2, items);
+  run_bursty<Mpmc, BlockingWait>("fixed 8", ElasticPolicy::fixed(8), 2, items);
+  run_bursty<Mpmc, BlockingWait>("elastic 1-8", ElasticPolicy::between(1, 8), 2, items);
+}
+
+/// Simulates a consumer outage: the producer enqueues every item while no
+/// one consumes, spilling whatever does not fit, then a consumer drains it
+template<typename Payload>
+void run_outage(const std::string &type, FsyncPolicy fsync, size_t items) {
+  SpillOptions options("/tmp/producer_consumer_benchmark.journal");
+  options.fsync = fsync;
+  SpillRingBuffer<Payload> buffer(1024, options);
+
+  uint64_t start = now_ns();
+  for (size_t n = 0; n < items; ++n) buffer.enqueue_sync(make_payload<Payload>(n));
+  uint64_t produced = now_ns();
+  uint64_t spilled = buffer.spilled();
+  for (size_t n = 0; n < items; ++n) buffer.dequeue_sync();
+  uint64_t drained = now_ns();
+
+  std::cout << std::left << std::setw(20) << (fsync == FSYNC_NONE ? "spill outage" : "spill outage/fsync")
+            << std::setw(8) << type << std::right << std::fixed << std::setprecision(0)
+            << std::setw(14) << items * 1e9 / (produced - start) << " items/s in, "
+            << items * 1e9 / (drained - produced) << " items/s out, " << spilled << " spilled" << std::endl;
+}
+
+/// Runs source -> map -> filter -> batch -> sink, either with every stage
+/// on its own thread or with everything after the source fused onto it
+void run_pipeline(bool fused, size_t items) {
+  size_t threads = fused ? 0 : 1;
+  std::atomic<size_t> next(0);
+  std::atomic<uint64_t> checksum(0);
+
+  Pipeline pipeline = Pipeline::source<size_t>("source", [&](size_t &item) {
+        item = next++;
+        return item < items;
+      }, 1)
+      .map<Pod64>("map", [](size_t n) { return make_payload<Pod64>(n); }, threads)
+      .filter("filter", [](const Pod64 &pod) { return pod.words[0] % 3 != 0; }, threads)
+      .batch("batch", 32, threads)
+      .sink("sink", [&](std::vector<Pod64> &&batch) {
+        uint64_t sum = 0;
+        for (const Pod64 &pod : batch) sum += pod.words[0];
+        checksum += sum;
+      }, threads);
+  pipeline.run();
+
+  std::cout << (fused ? "pipeline, fused" : "pipeline, a thread per stage") << std::endl;
+  pipeline.print_stats(std::cout);
+}
+
+/// Lane 0 carries control messages and lane 1 bulk traffic; a plain ring
+/// ignores the lane
+template<typename Item>
+void enqueue_on(RingBuffer<Item, Mpmc, BlockingWait> &ring, const Item &item, size_t) {
+  ring.enqueue_sync(item);
+}
+
+template<typename Item>
+void enqueue_on(PriorityRingBuffer<Item, Mpmc, BlockingWait> &ring, const Item &item, size_t lane) {
+  ring.enqueue_sync(item, lane);
+}
+
+/// Measures how long control messages wait behind a bulk producer that
+/// keeps the queue full, in one FIFO ring or in a lane of their own
+template<typename Queue>
+void run_priority(const std::string &name, Queue &queue, size_t items) {
+  typedef Stamped<short> Item;
+  const size_t every = 100;  // Bulk items between control messages
+  LatencyHistogram control, bulk;
+
+  std::thread bulkProducer([&]() {
+    for (size_t n = 0; n < items; ++n) enqueue_on(queue, Item{0, now_ns()}, 1);
+  });
+  std::thread controlProducer([&]() {
+    for (size_t n = 0; n < items / every; ++n) {
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+      enqueue_on(queue, Item{1, now_ns()}, 0);
+    }
+  });
+  for (size_t n = 0; n < items + items / every; ++n) {
+    Item item = queue.dequeue_sync();
+    (item.payload ? control : bulk).record(now_ns() - item.stamp);
+  }
+  bulkProducer.join();
+  controlProducer.join();
+
+  std::cout << std::left << std::setw(20) << name << std::right
+            << "control p50 " << std::setw(10) << control.percentile(50)
+            << " p99 " << std::setw(10) << control.percentile(99)
+            << " ns, bulk p50 " << std::setw(10) << bulk.percentile(50) << " ns" << std::endl;
+}
+
+void compare_priority(size_t items) {
+  RingBuffer<Stamped<short>, Mpmc, BlockingWait> fifo(1024);
+  PriorityRingBuffer<Stamped<short>, Mpmc, BlockingWait> lanes(2, 1024, LaneSchedule::strict());
+  run_priority("fifo", fifo, items);
+  run_priority("priority lanes", lanes, items);
+}
+
+void print_usage() {
+  std::cout << "Usage: producer_consumer_benchmark [ITEMS]\n"
+            << "    ITEMS - The number of items moved per run (default 200000)\n";
+}
+
+int main(int argc, char *argv[]) {
+  long items = 200000;
+
+  if (argc > 2) {
+    std::cerr << "Error: Too many arguments!\n\n";
+    print_usage();
+    return 1;
+  }
+
+  // Parse arguments
+  try {
+    if (argc == 2) items = std::stol(argv[1]);
+    if (items <= 0) throw std::exception();
+  } catch (std::exception &e) {
+    std::cerr << "Error: Invalid arguments!\n\n";
+    print_usage();
+    return 1;
+  }
+
+  time_generation(static_cast<size_t>(items));
+
+  time_logging(LOG_INFO, 1, static_cast<size_t>(items));
+  time_logging(LOG_INFO, 64, static_cast<size_t>(items));
+  time_logging(LOG_OFF, 1, static_cast<size_t>(items));
+
+  std::cout << std::left << std::setw(18) << "queue"
+            << std::setw(10) << "driver"
+            << std::setw(8) << "type"
+            << std::setw(7) << "P:C"
+            << std::right << std::setw(6) << "size"
+            << std::setw(14) << "items/s"
+            << std::setw(10) << "p50 ns"
+            << std::setw(10) << "p99 ns"
+            << std::setw(10) << "p99.9 ns"
+            << std::endl;
+
+  sweep_queues<short>("short", static_cast<size_t>(items));
+  sweep_queues<Pod64>("pod64", static_cast<size_t>(items));
+  sweep_queues<std::string>("string", static_cast<size_t>(items));
+
+  report_stats<short, Locking, BlockingWait>("locking/blocking", "short", 4, 4, 16, static_cast<size_t>(items));
+  report_stats<short, Mpmc, SpinParkWait>("mpmc/spinpark", "short", 4, 4, 16, static_cast<size_t>(items));
+
+  sweep_placement<short, Mpmc, SpinParkWait>("mpmc/spinpark", "short", static_cast<size_t>(items));
+
+  compare_multicast<Pod64>("pod64", static_cast<size_t>(items));
+  compare_multicast<std::string>("string", static_cast<size_t>(items));
+
+  sweep_bursty(std::min<size_t>(static_cast<size_t>(items), 20000));
+
+  run_outage<Pod64>("pod64", FSYNC_NONE, static_cast<size_t>(items));
+  run_outage<Pod64>("pod64", FSYNC_CHUNK, static_cast<size_t>(items));
+
+  run_pipeline(false, static_cast<size_t>(items));
+  run_pipeline(true, static_cast<size_t>(items));
+
+  compare_priority(static_cast<size_t>(items));
+
+  sweep_scaling<short, Locking, BlockingWait>("locking/blocking", "short", static_cast<size_t>(items));
+  sweep_scaling<short, Mpmc, BlockingWait>("mpmc/blocking", "short", static_cast<size_t>(items));
+
+  return 0;
+}
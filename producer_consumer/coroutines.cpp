@@ -0,0 +1,92 @@
+/*
+ * Peter Nguyen
+ * CSCI 411 - Producer Consumer - Coroutines
+ *
+ * Compile with `-std=c++20 -O2 -pthread`
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "CoroutineRingBuffer.h"
+
+typedef AsyncRingBuffer<uint64_t, Mpmc> Ring;
+
+/// Enqueues count items, each its producer id times a million plus its number
+CoTask produce(Ring &ring, uint64_t id, uint64_t count) {
+  for (uint64_t n = 0; n < count; ++n) co_await ring.enqueue(id * 1000000 + n);
+}
+
+/// Dequeues items until it has taken its share, adding them up
+CoTask consume(Ring &ring, uint64_t count, std::atomic<uint64_t> &sum) {
+  uint64_t local = 0;
+  for (uint64_t n = 0; n < count; ++n) local += co_await ring.dequeue();
+  sum += local;
+}
+
+void print_usage() {
+  std::cout << "Usage: producer_consumer_coroutines [PRODUCERS] [ITEMS] [THREADS]\n"
+            << "    PRODUCERS - The number of producer coroutines (default 10000)\n"
+            << "    ITEMS - The number of items each producer enqueues (default 10)\n"
+            << "    THREADS - The number of executor threads (default 2)\n";
+}
+
+int main(int argc, char *argv[]) {
+  long producers = 10000, items = 10, threads = 2;
+
+  if (argc > 4) {
+    std::cerr << "Error: Too many arguments!\n\n";
+    print_usage();
+    return 1;
+  }
+
+  // Parse arguments
+  try {
+    if (argc >= 2) producers = std::stol(argv[1]);
+    if (argc >= 3) items = std::stol(argv[2]);
+    if (argc == 4) threads = std::stol(argv[3]);
+    if (producers <= 0 || items <= 0 || threads <= 0) throw std::exception();
+  } catch (std::exception &e) {
+    std::cerr << "Error: Invalid arguments!\n\n";
+    print_usage();
+    return 1;
+  }
+
+  // A small ring, so most producers spend their time parked
+  Ring ring(64);
+  CoExecutor executor(static_cast<size_t>(threads));
+  uint64_t total = static_cast<uint64_t>(producers) * static_cast<uint64_t>(items);
+  std::atomic<uint64_t> sum(0);
+
+  auto start = std::chrono::steady_clock::now();
+  for (long id = 0; id < producers; ++id) {
+    executor.spawn(produce(ring, static_cast<uint64_t>(id), static_cast<uint64_t>(items)));
+  }
+
+  // Half the items go to a coroutine consumer and half to a plain thread
+  // using the blocking API, on the same ring
+  executor.spawn(consume(ring, total / 2, sum));
+  std::thread blocking([&]() {
+    uint64_t local = 0;
+    for (uint64_t n = total / 2; n < total; ++n) local += ring.dequeue_sync();
+    sum += local;
+  });
+
+  blocking.join();
+  executor.wait_idle();
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  uint64_t expected = 0;
+  for (uint64_t id = 0; id < static_cast<uint64_t>(producers); ++id) {
+    expected += id * 1000000 * items + static_cast<uint64_t>(items) * (items - 1) / 2;
+  }
+
+  std::cout << producers << " producer coroutines on " << threads << " threads moved " << total
+            << " items in " << seconds << " s (" << static_cast<uint64_t>(total / seconds) << " items/s), "
+            << (sum == expected ? "checksum ok" : "checksum MISMATCH") << std::endl;
+  return sum == expected ? 0 : 1;
+}
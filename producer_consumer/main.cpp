@@ -7,23 +7,26 @@
 
 #include <iostream>
 #include <chrono>
+#include <random>
 
 #include "RingBuffer.h"
 #include "ProducerConsumer.h"
 
 void print_usage() {
-  std::cout << "Usage: producer_consumer [SECONDS] [NUM_PRODUCERS] [NUM_CONSUMERS]\n"
+  std::cout << "Usage: producer_consumer [SECONDS] [NUM_PRODUCERS] [NUM_CONSUMERS] [SEED]\n"
             << "    SECONDS       - The number of seconds to run\n"
             << "    NUM_PRODUCERS - The number of producers\n"
-            << "    NUM_CONSUMERS - The number of consumers\n";
+            << "    NUM_CONSUMERS - The number of consumers\n"
+            << "    SEED          - Replays the items and timing of an earlier run\n";
 }
 
 int main(int argc, char *argv[]) {
   int sleep_seconds = 2,
       num_producer_threads = 4,
       num_consumer_threads = 4;
+  unsigned long long seed = 0;
 
-  if (argc > 4) {
+  if (argc > 5) {
     std::cerr << "Error: Too many arguments!\n\n";
     print_usage();
     return 1;
@@ -31,12 +34,10 @@ int main(int argc, char *argv[]) {
 
   // Parse arguments
   try {
-    switch (argc) {
-      case 4:num_consumer_threads = std::stoi(argv[3]);
-      case 3:num_producer_threads = std::stoi(argv[2]);
-      case 2:sleep_seconds = std::stoi(argv[1]);
-      default:break;
-    }
+    if (argc >= 2) sleep_seconds = std::stoi(argv[1]);
+    if (argc >= 3) num_producer_threads = std::stoi(argv[2]);
+    if (argc >= 4) num_consumer_threads = std::stoi(argv[3]);
+    if (argc >= 5) seed = std::stoull(argv[4]);
 
     // Arguments must be positive
     if (sleep_seconds < 0 || num_consumer_threads < 0 || num_producer_threads < 0)
@@ -57,12 +58,24 @@ int main(int argc, char *argv[]) {
       static_cast<size_t>(num_consumer_threads)
   );
 
+  // Producers and consumers each wait 250-500 ms between items, as
+  // drawn from the seed; the consumers' stream differs from the producers'
+  while (seed == 0) seed = (static_cast<unsigned long long>(std::random_device()()) << 32) | std::random_device()();
+  producerConsumer.set_load(
+      LoadProfile::uniform(std::chrono::milliseconds(250), std::chrono::milliseconds(500), seed),
+      LoadProfile::uniform(std::chrono::milliseconds(250), std::chrono::milliseconds(500), seed)
+  );
+
   // Start the system
   producerConsumer.start();
+  std::cout << "Seed: " << seed << std::endl;
 
   // Sleep the main thread
   std::chrono::seconds sleep_duration(sleep_seconds);
   std::this_thread::sleep_for(sleep_duration);
 
+  // Stop the threads
+  producerConsumer.stop();
+
   return 0;
 }
@@ -0,0 +1,278 @@
+/*
+ * Peter Nguyen
+ * CSCI 411 - Producer Consumer - Tests
+ *
+ * Compile with `-std=c++11 -pthread -lrt`
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "ElasticPool.h"
+#include "ProducerConsumer.h"
+#include "RingBuffer.h"
+#include "SharedRingBuffer.h"
+#include "SpillRingBuffer.h"
+#include "UnboundedRingBuffer.h"
+
+/// Reports a failed check
+///
+/// \return ok
+bool check(bool ok, const std::string &what) {
+  if (!ok) std::cerr << "Failed: " << what << std::endl;
+  return ok;
+}
+
+/// A forked producer attaches to the buffer by name and sends 1..ITEMS;
+/// the creating process must receive all of them, in order
+bool test_shared_ring() {
+  const uint64_t ITEMS = 100000;
+  const std::string name = "/csci411-test-ring-" + std::to_string(getpid());
+
+  SharedRingBuffer<uint64_t> ring(name, 64);
+
+  // A second owner must not replace a live buffer
+  bool refused = false;
+  try {
+    SharedRingBuffer<uint64_t> second(name, 64);
+  } catch (std::runtime_error &) {
+    refused = true;
+  }
+  if (!check(refused, "creating a buffer that exists throws")) return false;
+
+  pid_t pid = fork();
+  if (pid == -1) return check(false, "fork");
+  if (pid == 0) {
+    // Leave without destructors, which would unlink the creator's name
+    int status = 0;
+    try {
+      SharedRingBuffer<uint64_t> producer(name);
+      for (uint64_t i = 1; i <= ITEMS; ++i) producer.enqueue_sync(i);
+    } catch (std::exception &e) {
+      std::cerr << e.what() << std::endl;
+      status = 1;
+    }
+    _exit(status);
+  }
+
+  uint64_t sum = 0, last = 0;
+  bool ordered = true;
+  for (uint64_t i = 1; i <= ITEMS; ++i) {
+    uint64_t item = ring.dequeue_sync();
+    ordered = ordered && item == last + 1;
+    last = item;
+    sum += item;
+  }
+
+  int status = 0;
+  waitpid(pid, &status, 0);
+  return check(WIFEXITED(status) && WEXITSTATUS(status) == 0, "producer process exits cleanly")
+      && check(ordered, "items arrive in order")
+      && check(sum == ITEMS * (ITEMS + 1) / 2, "sum of transferred items");
+}
+
+/// Runs body(i) on count threads at once and waits for all of them
+template<typename Body>
+void run_threads(size_t count, Body body) {
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < count; ++i) threads.emplace_back(body, i);
+  for (std::thread &thread : threads) thread.join();
+}
+
+/// The high-water callback must fire exactly once each time the queue
+/// goes from below the mark to at or above it, however many threads race
+/// on the count
+bool test_high_water() {
+  const size_t MARK = 64, THREADS = 4, ROUNDS = 200;
+
+  RingBuffer<int, Unbounded> queue(16);
+  std::atomic<uint64_t> fired(0);
+  std::atomic<bool> sizeBelowMark(false);
+  queue.set_high_water(MARK, [&](size_t size) {
+    fired++;
+    if (size < MARK) sizeBelowMark = true;
+  });
+
+  // Producers together fill from empty to twice the mark, then consumers
+  // together drain it: one crossing a round
+  for (size_t round = 0; round < ROUNDS; ++round) {
+    run_threads(THREADS, [&](size_t) {
+      for (size_t i = 0; i < 2 * MARK / THREADS; ++i) queue.enqueue_sync(1);
+    });
+    run_threads(THREADS, [&](size_t) {
+      for (size_t i = 0; i < 2 * MARK / THREADS; ++i) queue.dequeue_sync();
+    });
+  }
+  if (!check(fired == ROUNDS, "one callback per fill from empty")) return false;
+
+  // Producers and consumers race around the mark, starting and ending just below it
+  for (size_t i = 0; i < MARK - 4; ++i) queue.enqueue_sync(1);
+  run_threads(2 * THREADS, [&](size_t i) {
+    for (size_t n = 0; n < 100000; ++n) {
+      if (i % 2 == 0) queue.enqueue_sync(1);
+      else queue.dequeue_sync();
+    }
+  });
+  if (!check(queue.size() == MARK - 4, "racing producers and consumers leave the queue below the mark")) return false;
+
+  // However the race went, the callback is armed again: the next crossing fires once
+  uint64_t before = fired;
+  for (size_t i = 0; i < MARK; ++i) queue.enqueue_sync(1);
+  return check(fired == before + 1, "one callback for the crossing after the race")
+      && check(!sizeBelowMark, "callbacks report a size at or above the mark");
+}
+
+/// Producers outrun a consumer on a small ring, so most items spill and
+/// come back through refills while producers keep inserting; each
+/// producer's items must still arrive in order, and all of them once
+bool test_spill_order() {
+  const uint64_t PRODUCERS = 3, ITEMS = 50000;
+
+  SpillOptions options("/tmp/producer_consumer_tests-" + std::to_string(getpid()) + ".journal");
+  options.chunkBytes = 4096;
+  SpillRingBuffer<uint64_t> buffer(8, options);
+
+  bool ordered = true;
+  std::thread consumer([&]() {
+    uint64_t next[PRODUCERS] = {};
+    for (uint64_t i = 0; i < PRODUCERS * ITEMS; ++i) {
+      uint64_t item = buffer.dequeue_sync();
+      uint64_t producer = item / ITEMS, n = item % ITEMS;
+      ordered = ordered && producer < PRODUCERS && n == next[producer];
+      if (producer < PRODUCERS) next[producer] = n + 1;
+    }
+  });
+  run_threads(PRODUCERS, [&](size_t producer) {
+    for (uint64_t n = 0; n < ITEMS; ++n) buffer.enqueue_sync(producer * ITEMS + n);
+  });
+  consumer.join();
+
+  return check(ordered, "each producer's items arrive in order")
+      && check(buffer.size() == 0 && buffer.spilled() == 0, "every item was removed once")
+      && check(buffer.spilled_total() > 0, "items were spilled");
+}
+
+/// A pool that shrinks and grows back must not start a worker while the
+/// thread that last had its id is still finishing, even one slow to notice
+bool test_elastic_ids() {
+  const size_t ROUNDS = 20;
+
+  std::atomic<size_t> depth(0);
+  std::atomic<int> running[2];
+  std::atomic<bool> overlapped(false);
+  for (std::atomic<int> &count : running) count = 0;
+
+  ElasticPolicy policy = ElasticPolicy::between(1, 2);
+  policy.interval = std::chrono::milliseconds(1);
+  policy.growAfter = policy.shrinkAfter = 1;
+  ElasticPool pool(policy, [&](size_t i, const std::atomic<bool> &active) {
+    if (running[i]++ != 0) overlapped = true;
+    while (active) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    // Keeps working a while after being retired, as a consumer in a handler would
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    running[i]--;
+  }, [&]() { return depth.load(); }, 10, []() { return uint64_t(0); });
+
+  pool.start();
+  for (size_t round = 0; round < ROUNDS; ++round) {
+    depth = 10;
+    while (pool.size() < 2) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    depth = 0;
+    while (pool.size() > 1) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  pool.stop();
+
+  return check(!overlapped, "no two workers run with the same id")
+      && check(pool.resizes() == 2 * ROUNDS, "the pool grew back every round");
+}
+
+/// Returns the number of threads in this process
+size_t count_threads() {
+  size_t count = 0;
+  DIR *tasks = opendir("/proc/self/task");
+  if (!tasks) return 0;
+  while (dirent *entry = readdir(tasks)) {
+    if (entry->d_name[0] != '.') count++;
+  }
+  closedir(tasks);
+  return count;
+}
+
+/// A uniform profile with its gaps set as given, which uniform() would order
+LoadProfile gaps(std::chrono::nanoseconds minGap, std::chrono::nanoseconds maxGap) {
+  LoadProfile profile;
+  profile.minGap = minGap;
+  profile.maxGap = maxGap;
+  return profile;
+}
+
+/// An invalid load profile must be refused by set_load, before start()
+/// could hand it to a worker thread, and leave the old profiles in place
+bool test_invalid_load() {
+  RingBuffer<int> ringBuffer(16);
+  ProducerConsumer<int> producerConsumer(std::ref(ringBuffer), 2, 2);
+  size_t threads = count_threads();
+
+  const LoadProfile INVALID[] = {
+      LoadProfile::constant(0),
+      LoadProfile::poisson(-1),
+      LoadProfile::bursty(1000, std::chrono::nanoseconds(0), std::chrono::milliseconds(1)),
+      LoadProfile::bursty(1000, std::chrono::milliseconds(1), std::chrono::milliseconds(-1)),
+      LoadProfile::bursty(1000, std::chrono::milliseconds(2), std::chrono::milliseconds(-1)),
+      LoadProfile::uniform(std::chrono::milliseconds(-1), std::chrono::milliseconds(1)),
+      gaps(std::chrono::milliseconds(2), std::chrono::milliseconds(1)),
+  };
+  for (const LoadProfile &profile : INVALID) {
+    size_t refused = 0;
+    try {
+      producerConsumer.set_load(profile, LoadProfile::constant(1000));
+    } catch (std::invalid_argument &) {
+      refused++;
+    }
+    try {
+      producerConsumer.set_load(LoadProfile::constant(1000), profile);
+    } catch (std::invalid_argument &) {
+      refused++;
+    }
+    if (!check(refused == 2, "set_load throws for an invalid profile")) return false;
+  }
+
+  return check(producerConsumer.producer_load().arrival == LoadProfile::UNIFORM, "a refused profile is not set")
+      && check(producerConsumer.consumer_pool() == nullptr, "no consumers were started")
+      && check(count_threads() == threads, "no threads were started");
+}
+
+struct Test {
+  const char *name;
+  bool (*run)();
+};
+
+const Test TESTS[] = {
+    {"shared_ring", test_shared_ring},
+    {"high_water", test_high_water},
+    {"spill_order", test_spill_order},
+    {"invalid_load", test_invalid_load},
+    {"elastic_ids", test_elastic_ids},
+};
+
+int main(int argc, char *argv[]) {
+  if (argc != 2) {
+    std::cerr << "Usage: producer_consumer_tests TEST\n";
+    return 2;
+  }
+
+  for (const Test &test : TESTS) {
+    if (std::strcmp(test.name, argv[1]) == 0) return test.run() ? 0 : 1;
+  }
+  std::cerr << "No test named " << argv[1] << std::endl;
+  return 2;
+}